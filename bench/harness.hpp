@@ -0,0 +1,198 @@
+#ifndef BENCH_HARNESS_H_
+#define BENCH_HARNESS_H_
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <ostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench {
+
+    // Counters bumped through the replacement global operator new installed in main.cpp
+    //
+    // Only allocations that go through operator new are seen. xtensor containers
+    // do unless XTENSOR_USE_XSIMD swaps in the xsimd aligned allocator.
+    struct AllocCounters {
+        std::atomic<std::uint64_t> count{0};
+        std::atomic<std::uint64_t> bytes{0};
+    };
+
+    inline AllocCounters& allocCounters() {
+        static AllocCounters counters;
+        return counters;
+    }
+
+    inline void countAlloc(std::size_t n) {
+        AllocCounters& c = allocCounters();
+        c.count.fetch_add(1, std::memory_order_relaxed);
+        c.bytes.fetch_add(n, std::memory_order_relaxed);
+    }
+
+    // Keeps the optimizer from discarding a value computed in a benchmark
+    template <typename T>
+    inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+        asm volatile("" : : "r,m"(value) : "memory");
+#else
+        static volatile const T* sink;
+        sink = &value;
+#endif
+    }
+
+    using Params = std::vector<std::pair<std::string, std::string>>;
+
+    struct Result {
+        std::string name;
+        Params params;
+        std::uint64_t iterations;
+        double nsPerOp;
+        double allocsPerOp;
+        double bytesPerOp;
+        double itemsPerSecond; // e.g. observations processed per second
+    };
+
+    struct Options {
+        std::string filter; // run benchmarks whose name contains this
+        double minTime = 0.2; // seconds per measurement
+        std::size_t maxN = 1000000; // largest series length
+        std::string out; // JSON file, stdout when empty
+    };
+
+    // Times callables with an adaptive iteration count
+    //
+    // The iteration count grows until one batch runs for at least minTime, and the
+    // final batch is the one reported together with the allocations it made.
+    class Runner {
+
+        public:
+
+            explicit Runner(Options opts) : m_opts(std::move(opts)) {}
+
+            const Options& options() const {return m_opts;}
+
+            bool enabled(const std::string& name) const {
+                return m_opts.filter.empty() || name.find(m_opts.filter) != std::string::npos;
+            }
+
+            // fn performs one operation, itemsPerOp scales the throughput
+            template <typename F>
+            void run(const std::string& name, Params params, double itemsPerOp, F&& fn) {
+                if (!enabled(name))
+                    return;
+
+                using clock = std::chrono::steady_clock;
+                AllocCounters& counters = allocCounters();
+
+                fn(); // warm up caches and any lazily sized workspace
+
+                std::uint64_t iters = 1;
+                for (;;) {
+                    const std::uint64_t count0 = counters.count.load(std::memory_order_relaxed);
+                    const std::uint64_t bytes0 = counters.bytes.load(std::memory_order_relaxed);
+                    const auto start = clock::now();
+                    for (std::uint64_t i = 0; i < iters; ++i)
+                        fn();
+                    const double elapsed = std::chrono::duration<double>(clock::now() - start).count();
+                    const std::uint64_t count1 = counters.count.load(std::memory_order_relaxed);
+                    const std::uint64_t bytes1 = counters.bytes.load(std::memory_order_relaxed);
+
+                    if (elapsed >= m_opts.minTime || iters >= (std::uint64_t(1) << 40)) {
+                        const double ops = static_cast<double>(iters);
+                        Result r{name, std::move(params), iters,
+                                 elapsed * 1e9 / ops,
+                                 static_cast<double>(count1 - count0) / ops,
+                                 static_cast<double>(bytes1 - bytes0) / ops,
+                                 itemsPerOp * ops / elapsed};
+                        report(r);
+                        m_results.push_back(std::move(r));
+                        return;
+                    }
+
+                    // aim slightly past minTime, at least doubling
+                    double scale = (elapsed > 0.0) ? 1.2 * m_opts.minTime / elapsed : 100.0;
+                    scale = std::min(std::max(scale, 2.0), 100.0);
+                    iters = static_cast<std::uint64_t>(static_cast<double>(iters) * scale);
+                }
+            }
+
+            void writeJson(std::ostream& os) const {
+                os << "{\n  \"context\": {\n";
+                os << "    \"library\": \"tsa-cpp\",\n";
+                os << "    \"compiler\": \"" << escape(compiler()) << "\",\n";
+#ifdef NDEBUG
+                os << "    \"assertions\": false,\n";
+#else
+                os << "    \"assertions\": true,\n";
+#endif
+                os << "    \"min_time_s\": " << m_opts.minTime << "\n";
+                os << "  },\n  \"benchmarks\": [\n";
+
+                os << std::setprecision(6);
+                for (std::size_t i = 0; i < m_results.size(); ++i) {
+                    const Result& r = m_results[i];
+                    os << "    {\"name\": \"" << escape(r.name) << "\", \"params\": {";
+                    for (std::size_t p = 0; p < r.params.size(); ++p) {
+                        os << (p ? ", " : "") << "\"" << escape(r.params[p].first) << "\": \""
+                           << escape(r.params[p].second) << "\"";
+                    }
+                    os << "}, \"iterations\": " << r.iterations
+                       << ", \"ns_per_op\": " << r.nsPerOp
+                       << ", \"allocs_per_op\": " << r.allocsPerOp
+                       << ", \"bytes_per_op\": " << r.bytesPerOp
+                       << ", \"items_per_second\": " << r.itemsPerSecond << "}"
+                       << (i + 1 < m_results.size() ? ",\n" : "\n");
+                }
+                os << "  ]\n}\n";
+            }
+
+        private:
+
+            static std::string escape(const std::string& s) {
+                std::string out;
+                out.reserve(s.size());
+                for (char c : s) {
+                    if (c == '"' || c == '\\')
+                        out += '\\';
+                    out += c;
+                }
+                return out;
+            }
+
+            static std::string compiler() {
+#if defined(__clang__)
+                return "clang " __clang_version__;
+#elif defined(__GNUC__)
+                return "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+                return "msvc " + std::to_string(_MSC_VER);
+#else
+                return "unknown";
+#endif
+            }
+
+            // One progress line per benchmark on stderr, JSON goes to stdout or a file
+            static void report(const Result& r) {
+                std::cerr << std::left << std::setw(28) << r.name;
+                for (const auto& p : r.params)
+                    std::cerr << ' ' << p.first << '=' << p.second;
+                std::cerr << std::right << std::fixed << std::setprecision(1)
+                          << "  " << r.nsPerOp << " ns/op  "
+                          << r.bytesPerOp << " B/op  "
+                          << std::scientific << std::setprecision(3) << r.itemsPerSecond << " items/s"
+                          << std::defaultfloat << '\n';
+            }
+
+            Options m_opts;
+            std::vector<Result> m_results;
+    };
+
+}
+
+#endif // BENCH_HARNESS_H_
@@ -0,0 +1,472 @@
+/**
+ * tsa_bench : microbenchmarks for the hot kernels of the library
+ *
+ * Usage : tsa_bench [--filter=<substring>] [--min-time=<seconds>] [--max-n=<n>] [--out=<file>]
+ *
+ * Every benchmark is run over series lengths 1e2, ..., 1e6 (capped by --max-n) and,
+ * where it applies, over maxlag values and regression types. Progress is printed to
+ * stderr and the results are written as JSON to --out or stdout, reporting ns/op,
+ * allocations and bytes allocated per op, and observations processed per second.
+ */
+
+#include "harness.hpp"
+
+// Allocation counting, the library's replacement operator new also feeds the per
+// op counters, so a TSA_INSTRUMENT build reports per stage allocations as well
+#define TSA_INSTRUMENT_DEFINE_ALLOC_HOOKS
+#define TSA_INSTRUMENT_ALLOC_OBSERVER(n) ::bench::countAlloc(n)
+#include "tools/instrumentation.hpp"
+
+#include "models/linear/KalmanRegression.hpp"
+#include "models/linear/OLSModel.hpp"
+#include "models/linear/RollingOLS.hpp"
+#include "sizing/AdaptiveKelly.hpp"
+#include "sizing/KellyCriterion.hpp"
+#include "sizing/PortfolioKelly.hpp"
+#include "tests/ADFT.hpp"
+#include "tests/Hurst.hpp"
+#include "tests/KPSS.hpp"
+#include "tests/PhillipsPerron.hpp"
+#include "tests/SADF.hpp"
+#include "tools/autoReg.hpp"
+#include "tools/coreTools.hpp"
+#include "tools/lagMatrix.hpp"
+#include "tools/lagVariance.hpp"
+#include "tools/rolling.hpp"
+
+#include <cstdlib>
+#include <fstream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include <xtensor/containers/xtensor.hpp>
+
+// === Inputs ===
+
+namespace {
+
+    // Gaussian random walk around a price level
+    xt::xtensor<double, 1> randomWalk(std::size_t n, std::uint64_t seed) {
+        std::mt19937_64 gen(seed);
+        std::normal_distribution<double> noise(0.0, 1.0);
+        xt::xtensor<double, 1> x = xt::empty<double>({n});
+        double level = 100.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            level += noise(gen);
+            x(i) = level;
+        }
+        return x;
+    }
+
+    // Mean reverting AR(1) spread
+    xt::xtensor<double, 1> arOne(std::size_t n, double phi, std::uint64_t seed) {
+        std::mt19937_64 gen(seed);
+        std::normal_distribution<double> noise(0.0, 1.0);
+        xt::xtensor<double, 1> x = xt::empty<double>({n});
+        double v = 0.0;
+        for (std::size_t i = 0; i < n; ++i) {
+            v = phi * v + noise(gen);
+            x(i) = v;
+        }
+        return x;
+    }
+
+    std::vector<std::size_t> lengths(std::size_t maxN) {
+        std::vector<std::size_t> out;
+        for (std::size_t n = 100; n <= maxN; n *= 10)
+            out.push_back(n);
+        return out;
+    }
+
+    const int maxlags[] = {4, 12};
+    const char* regressions[] = {"n", "c", "ct"};
+
+}
+
+// === Benchmarks ===
+
+namespace {
+
+    void benchADF(bench::Runner& runner) {
+        for (std::size_t n : lengths(runner.options().maxN)) {
+            xt::xtensor<double, 1> x = randomWalk(n, 1);
+            for (int maxlag : maxlags) {
+                if (static_cast<std::size_t>(maxlag) * 2 + 4 >= n)
+                    continue;
+                for (const char* reg : regressions) {
+                    bench::Params p = {{"n", std::to_string(n)}, {"maxlag", std::to_string(maxlag)}, {"regression", reg}};
+
+                    runner.run("adfuller", p, static_cast<double>(n), [&] {
+                        bench::doNotOptimize(tests::adf::adfuller(x, maxlag, reg, "AIC").adfstat);
+                    });
+
+                    // workspace reused across calls, as the batch drivers do
+                    tests::adf::ADFWorkspace ws;
+                    runner.run("adfuller_workspace", p, static_cast<double>(n), [&] {
+                        bench::doNotOptimize(tests::adf::adfuller(x, ws, maxlag, reg, "AIC").adfstat);
+                    });
+                }
+            }
+        }
+    }
+
+    void benchKPSS(bench::Runner& runner) {
+        for (std::size_t n : lengths(runner.options().maxN)) {
+            xt::xtensor<double, 1> x = randomWalk(n, 1);
+            for (const char* reg : {"c", "ct"}) {
+                for (const char* nlags : {"auto", "legacy"}) {
+                    tests::KPSSWorkspace ws;
+                    const tools::trendType trend = tools::parseTrend(reg);
+                    const int lags = tests::detail::parseKPSSLags(nlags, n);
+                    runner.run("kpss_workspace", {{"n", std::to_string(n)}, {"regression", reg}, {"nlags", nlags}},
+                               static_cast<double>(n), [&] {
+                        bench::doNotOptimize(tests::kpss(x, ws, trend, lags).kpssstat);
+                    });
+                }
+            }
+        }
+    }
+
+    void benchPP(bench::Runner& runner) {
+        for (std::size_t n : lengths(runner.options().maxN)) {
+            xt::xtensor<double, 1> x = randomWalk(n, 1);
+            for (const char* reg : {"c", "ct"}) {
+                for (const char* type : {"tau", "rho"}) {
+                    tests::adf::ADFWorkspace ws;
+                    const tools::trendType trend = tools::parseTrend(reg);
+                    const tests::ppTestType testType = tests::detail::parsePPTest(type);
+                    runner.run("pp_workspace", {{"n", std::to_string(n)}, {"regression", reg}, {"test", type}},
+                               static_cast<double>(n), [&] {
+                        bench::doNotOptimize(tests::pp(x, ws, -1, trend, testType).stat);
+                    });
+                }
+            }
+        }
+    }
+
+    void benchAutoLag(bench::Runner& runner) {
+        for (std::size_t n : lengths(runner.options().maxN)) {
+            xt::xtensor<double, 1> x = randomWalk(n, 2);
+            std::vector<double> dx(n - 1);
+            for (std::size_t i = 0; i + 1 < n; ++i)
+                dx[i] = x(i + 1) - x(i);
+
+            for (int maxlag : maxlags) {
+                if (static_cast<std::size_t>(maxlag) * 2 + 4 >= n)
+                    continue;
+                const std::size_t nobs = dx.size() - maxlag;
+                tools::LagMatrix X(dx.data(), dx.size(), maxlag, maxlag + 1, 1, true, x.data() + (n - nobs - 1));
+                tools::VectorView y(dx.data() + maxlag, nobs);
+                linModels::NestedOLS nested;
+
+                for (const char* method : {"AIC", "BIC", "t-stat"}) {
+                    runner.run("autoLag", {{"n", std::to_string(n)}, {"maxlag", std::to_string(maxlag)}, {"method", method}},
+                               static_cast<double>(n), [&] {
+                        bench::doNotOptimize(tools::autoLag(linModels::OLS, X, y, 2, maxlag, method, nested).bestLag);
+                    });
+                }
+            }
+        }
+    }
+
+    void benchOLS(bench::Runner& runner) {
+        std::mt19937_64 gen(3);
+        std::normal_distribution<double> noise(0.0, 1.0);
+
+        for (std::size_t n : lengths(runner.options().maxN)) {
+            for (std::size_t k : {std::size_t(2), std::size_t(8)}) {
+                xt::xtensor<double, 2> X = xt::empty<double>({n, k});
+                xt::xtensor<double, 1> y = xt::empty<double>({n});
+                for (std::size_t i = 0; i < n; ++i) {
+                    double v = noise(gen);
+                    for (std::size_t j = 0; j < k; ++j) {
+                        X(i, j) = (j == 0) ? 1.0 : noise(gen);
+                        v += 0.5 * X(i, j);
+                    }
+                    y(i) = v;
+                }
+
+                for (auto solver : {linModels::CHOLESKY, linModels::QR, linModels::SVD}) {
+                    const char* name = (solver == linModels::CHOLESKY) ? "cholesky" : (solver == linModels::QR) ? "qr" : "svd";
+                    linModels::OLSModel model(X, y, solver);
+                    runner.run("OLSModel::fit", {{"n", std::to_string(n)}, {"k", std::to_string(k)}, {"solver", name}},
+                               static_cast<double>(n), [&] {
+                        bench::doNotOptimize(model.fit().aic);
+                    });
+                }
+            }
+        }
+    }
+
+    void benchDesign(bench::Runner& runner) {
+        for (std::size_t n : lengths(runner.options().maxN)) {
+            xt::xtensor<double, 1> x = randomWalk(n, 4);
+
+            for (int maxlag : maxlags) {
+                runner.run("lagmat", {{"n", std::to_string(n)}, {"maxlag", std::to_string(maxlag)}},
+                           static_cast<double>(n), [&] {
+                    bench::doNotOptimize(tools::lagmat(x, maxlag, "both", "in").data());
+                });
+            }
+
+            for (const char* trend : {"c", "ct", "ctt"}) {
+                runner.run("addTrend", {{"n", std::to_string(n)}, {"trend", trend}},
+                           static_cast<double>(n), [&] {
+                    bench::doNotOptimize(tools::addTrend(x, trend, true).data());
+                });
+            }
+        }
+    }
+
+    void benchHurst(bench::Runner& runner) {
+        for (std::size_t n : lengths(runner.options().maxN)) {
+            if (n <= 200)
+                continue; // default lags run to 99
+            xt::xarray<double> x = randomWalk(n, 5);
+
+            runner.run("hurst", {{"n", std::to_string(n)}, {"lags", "2..99"}}, static_cast<double>(n), [&] {
+                bench::doNotOptimize(tests::hurst(x));
+            });
+
+            const std::vector<int> lags = tools::logLags(2, static_cast<int>(n / 10), 24);
+            runner.run("hurst", {{"n", std::to_string(n)}, {"lags", "log24"}}, static_cast<double>(n), [&] {
+                bench::doNotOptimize(tests::hurst(x, lags));
+            });
+        }
+    }
+
+    void benchHalfLife(bench::Runner& runner) {
+        for (std::size_t n : lengths(runner.options().maxN)) {
+            xt::xtensor<double, 1> x = arOne(n, 0.9, 6);
+            runner.run("AROneHalfLife", {{"n", std::to_string(n)}}, static_cast<double>(n), [&] {
+                bench::doNotOptimize(tools::AROneHalfLife(x));
+            });
+        }
+
+        // panel of spreads of end of day length, one op is the whole panel
+        for (std::size_t rows : {std::size_t(1000), std::size_t(10000)}) {
+            const std::size_t n = 250;
+            xt::xtensor<double, 2> panel = xt::empty<double>({rows, n});
+            for (std::size_t r = 0; r < rows; ++r) {
+                xt::xtensor<double, 1> x = arOne(n, 0.9, 100 + r);
+                std::copy(x.begin(), x.end(), panel.data() + r * n);
+            }
+            xt::xtensor<double, 1> phi, hl;
+            for (std::size_t threads : {std::size_t(1), std::size_t(0)}) {
+                runner.run("AROnePanel", {{"rows", std::to_string(rows)}, {"n", std::to_string(n)},
+                           {"threads", std::to_string(threads)}}, static_cast<double>(rows * n), [&] {
+                    tools::AROnePanel(panel, phi, hl, threads);
+                    bench::doNotOptimize(hl(0));
+                });
+            }
+        }
+    }
+
+    void benchSADF(bench::Runner& runner) {
+        for (std::size_t n : {std::size_t(1000), std::size_t(5000)}) {
+            if (n > runner.options().maxN)
+                continue;
+            xt::xtensor<double, 1> x = randomWalk(n, 21);
+            for (int lag : {0, 2}) {
+                runner.run("SADF", {{"n", std::to_string(n)}, {"lag", std::to_string(lag)}}, static_cast<double>(n), [&] {
+                    bench::doNotOptimize(tests::adf::sadf(x, 0, lag).stat);
+                });
+                runner.run("GSADF", {{"n", std::to_string(n)}, {"lag", std::to_string(lag)}}, static_cast<double>(n), [&] {
+                    bench::doNotOptimize(tests::adf::gsadf(x, 0, lag).stat);
+                });
+            }
+        }
+
+        // one op is one observation through the monitor, 1000 start points open
+        const xt::xtensor<double, 1> series = randomWalk(1 << 14, 23);
+        tests::adf::BSADFMonitor monitor(100, 1, tools::trendType::C, 1000);
+        std::size_t i = 0;
+        runner.run("BSADFMonitor", {{"maxWindow", "1000"}, {"lag", "1"}}, 1.0, [&] {
+            bench::doNotOptimize(monitor.update(series(i)));
+            if (++i == series.size())
+                i = 0;
+        });
+    }
+
+    // One update per op, cycling through a pre-generated stream
+    template <typename R>
+    void runRolling(bench::Runner& runner, const std::string& name, bench::Params p, R& roll,
+                    const std::vector<double>& stream) {
+        std::size_t i = 0;
+        runner.run(name, std::move(p), 1.0, [&] {
+            bench::doNotOptimize(roll.update(stream[i]));
+            if (++i == stream.size())
+                i = 0;
+        });
+    }
+
+    void benchRolling(bench::Runner& runner) {
+        const xt::xtensor<double, 1> series = arOne(1 << 16, 0.95, 7);
+        std::vector<double> stream(series.begin(), series.end());
+
+        for (std::size_t w : {std::size_t(100), std::size_t(1000)}) {
+            xt::xtensor<double, 1> window = xt::view(series, xt::range(0, w));
+            const std::string ws = std::to_string(w);
+
+            tools::rolling::Mean mean(0.0, window);
+            runRolling(runner, "rolling::Mean", {{"window", ws}}, mean, stream);
+
+            tools::rolling::StandardDeviation sd(0.0, window);
+            runRolling(runner, "rolling::StandardDeviation", {{"window", ws}}, sd, stream);
+
+            tools::rolling::HalfLife hl(0.0, window);
+            runRolling(runner, "rolling::HalfLife", {{"window", ws}}, hl, stream);
+
+            tools::rolling::Hurst hu(0.0, window, tools::logLags(2, static_cast<int>(w / 4), 16));
+            runRolling(runner, "rolling::Hurst", {{"window", ws}, {"lags", "log16"}}, hu, stream);
+
+            for (const char* reg : regressions) {
+                tools::rolling::ADF adf(0.0, window, 1, reg);
+                runRolling(runner, "rolling::ADF", {{"window", ws}, {"lag", "1"}, {"regression", reg}}, adf, stream);
+            }
+
+            tools::rolling::KPSS kpss(0.0, window);
+            runRolling(runner, "rolling::KPSS", {{"window", ws}, {"lags", std::to_string(kpss.lags())}}, kpss, stream);
+        }
+    }
+
+    void benchRollingOLS(bench::Runner& runner) {
+        const std::size_t n = 1 << 16;
+        std::mt19937_64 gen(19);
+        std::normal_distribution<double> dist(0.0, 1.0);
+
+        for (std::size_t p : {1, 4, 8}) {
+            std::vector<double> X(n * p), y(n);
+            for (std::size_t i = 0; i < n; ++i) {
+                double s = dist(gen);
+                for (std::size_t j = 0; j < p; ++j) {
+                    X[i * p + j] = dist(gen);
+                    s += 0.5 * X[i * p + j];
+                }
+                y[i] = s;
+            }
+
+            for (std::size_t window : {60, 250}) {
+                linModels::RollingOLS ols(p, window);
+                std::size_t i = 0;
+                runner.run("RollingOLS", {{"k", std::to_string(p + 1)}, {"window", std::to_string(window)}}, 1.0, [&] {
+                    ols.update(X.data() + i * p, y[i]);
+                    bench::doNotOptimize(ols.rss());
+                    if (++i == n)
+                        i = 0;
+                });
+            }
+        }
+    }
+
+    void benchKalman(bench::Runner& runner) {
+        const xt::xtensor<double, 1> xs = randomWalk(1 << 16, 13);
+        const xt::xtensor<double, 1> noise = arOne(1 << 16, 0.9, 17);
+        std::vector<double> x(xs.begin(), xs.end());
+        std::vector<double> y(x.size());
+        for (std::size_t i = 0; i < y.size(); ++i)
+            y[i] = 0.5 + 1.3 * x[i] + noise(i);
+
+        linModels::KalmanRegression kf(1e-4, 1e-3);
+        std::size_t i = 0;
+        runner.run("KalmanRegression", {{"op", "update"}}, 1.0, [&] {
+            bench::doNotOptimize(kf.update(x[i], y[i]).zscore);
+            if (++i == x.size())
+                i = 0;
+        });
+    }
+
+    void benchKelly(bench::Runner& runner) {
+        sizing::Kelly kelly;
+        runner.run("Kelly", {{"op", "record+get"}}, 2.0, [&] {
+            kelly.recordWin(1.5);
+            kelly.recordLoss(1.0);
+            bench::doNotOptimize(kelly.getKelly());
+        });
+
+        sizing::WindowedKelly windowed(256);
+        runner.run("WindowedKelly", {{"op", "record"}, {"window", "256"}}, 2.0, [&] {
+            windowed.recordWin(1.5);
+            windowed.recordLoss(1.0);
+        });
+        runner.run("WindowedKelly", {{"op", "get"}, {"window", "256"}}, 1.0, [&] {
+            bench::doNotOptimize(windowed.getKelly());
+        });
+
+        sizing::DecayedKelly decayed(0.99);
+        runner.run("DecayedKelly", {{"op", "record+get"}, {"lambda", "0.99"}}, 2.0, [&] {
+            decayed.recordWin(1.5);
+            decayed.recordLoss(1.0);
+            bench::doNotOptimize(decayed.getKelly());
+        });
+
+        for (std::size_t nAssets : {20, 200}) {
+            const std::string na = std::to_string(nAssets);
+            std::mt19937_64 gen(11);
+            std::normal_distribution<double> dist(0.0005, 0.01);
+            std::vector<double> r(nAssets), f(nAssets);
+
+            sizing::PortfolioKelly portfolio(nAssets, 1e-4, 10.0, 0.5);
+            runner.run("PortfolioKelly", {{"op", "update"}, {"assets", na}}, 1.0, [&] {
+                for (double& v : r)
+                    v = dist(gen);
+                portfolio.update(r.data());
+            });
+            runner.run("PortfolioKelly", {{"op", "get"}, {"assets", na}}, 1.0, [&] {
+                portfolio.getKelly(f.data());
+                bench::doNotOptimize(f.data());
+            });
+        }
+    }
+
+}
+
+int main(int argc, char** argv) {
+    bench::Options opts;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        auto value = [&](const char* key) -> const char* {
+            const std::string k = std::string(key) + "=";
+            return arg.compare(0, k.size(), k) == 0 ? argv[i] + k.size() : nullptr;
+        };
+
+        if (const char* v = value("--filter")) opts.filter = v;
+        else if (const char* v = value("--min-time")) opts.minTime = std::atof(v);
+        else if (const char* v = value("--max-n")) opts.maxN = static_cast<std::size_t>(std::atof(v));
+        else if (const char* v = value("--out")) opts.out = v;
+        else {
+            std::cerr << "usage : tsa_bench [--filter=<substring>] [--min-time=<seconds>] [--max-n=<n>] [--out=<file>]\n";
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    bench::Runner runner(opts);
+
+    benchADF(runner);
+    benchKPSS(runner);
+    benchPP(runner);
+    benchAutoLag(runner);
+    benchOLS(runner);
+    benchDesign(runner);
+    benchHurst(runner);
+    benchHalfLife(runner);
+    benchRolling(runner);
+    benchSADF(runner);
+    benchRollingOLS(runner);
+    benchKalman(runner);
+    benchKelly(runner);
+
+    if (opts.out.empty()) {
+        runner.writeJson(std::cout);
+    } else {
+        std::ofstream file(opts.out);
+        if (!file) {
+            std::cerr << "tsa_bench : Could not open " << opts.out << '\n';
+            return 1;
+        }
+        runner.writeJson(file);
+    }
+
+    return 0;
+}
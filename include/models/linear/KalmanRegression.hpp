@@ -0,0 +1,133 @@
+#ifndef KALMANREGRESSION_H_
+#define KALMANREGRESSION_H_
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+namespace linModels {
+
+    // Filter output for one observation
+    template <typename T>
+    struct BasicKalmanStep {
+        T alpha; // intercept after the update
+        T beta; // hedge ratio after the update
+        T spread; // forecast error y - (alpha + beta x) under the prior state
+        T variance; // forecast error variance
+        T zscore; // spread / sqrt(variance)
+    };
+
+    using KalmanStep = BasicKalmanStep<double>;
+
+    // Time varying regression y_t = alpha_t + beta_t x_t + v_t by Kalman filter
+    //
+    // The state (alpha, beta) follows a random walk with process noise
+    // diag(qAlpha, qBeta) and the observation noise variance is r. The state
+    // covariance is a symmetric 2x2 matrix held in three scalars, so an update is
+    // a fixed handful of flops with no allocation. With the delta constructor the
+    // process noise is delta / (1 - delta) I, the usual pairs trading
+    // parameterization where a smaller delta gives a slower moving hedge ratio.
+    template <typename T>
+    class BasicKalmanRegression {
+
+        public:
+
+            BasicKalmanRegression(T delta = 1e-4, T r = 1e-3) {
+                if (!(delta > 0.0 && delta < 1.0))
+                    throw std::invalid_argument("linModels::KalmanRegression : Delta must be in (0, 1).");
+                setObservationNoise(r);
+                T q = delta / (1 - delta);
+                setProcessNoise(q, q);
+            }
+
+            BasicKalmanRegression(T qAlpha, T qBeta, T r) {
+                setProcessNoise(qAlpha, qBeta);
+                setObservationNoise(r);
+            }
+
+            void setProcessNoise(T qAlpha, T qBeta) {
+                if (qAlpha < 0.0 || qBeta < 0.0)
+                    throw std::invalid_argument("linModels::KalmanRegression : Process noise must be non-negative.");
+                m_qa = qAlpha;
+                m_qb = qBeta;
+            }
+
+            void setObservationNoise(T r) {
+                if (!(r > 0.0))
+                    throw std::invalid_argument("linModels::KalmanRegression : Observation noise must be positive.");
+                m_r = r;
+            }
+
+            // Prior state and covariance diag(pAlpha, pBeta), e.g. from an OLS fit on a warm up window
+            void reset(T alpha, T beta, T pAlpha = 1.0, T pBeta = 1.0) {
+                m_alpha = alpha;
+                m_beta = beta;
+                m_p00 = pAlpha;
+                m_p01 = 0.0;
+                m_p11 = pBeta;
+                m_count = 0;
+            }
+
+            // Filters one observation of the pair
+            BasicKalmanStep<T> update(T x, T y) {
+                // predict, the state is a random walk so only the covariance grows
+                const T r00 = m_p00 + m_qa;
+                const T r01 = m_p01;
+                const T r11 = m_p11 + m_qb;
+
+                // forecast error and its variance with h = (1, x)
+                const T e = y - (m_alpha + m_beta * x);
+                const T ph0 = r00 + r01 * x;
+                const T ph1 = r01 + r11 * x;
+                const T s = ph0 + ph1 * x + m_r;
+
+                // gain and update
+                const T k0 = ph0 / s;
+                const T k1 = ph1 / s;
+                m_alpha += k0 * e;
+                m_beta += k1 * e;
+
+                m_p00 = r00 - k0 * ph0;
+                m_p01 = r01 - k0 * ph1;
+                m_p11 = r11 - k1 * ph1;
+
+                ++m_count;
+
+                m_last = {m_alpha, m_beta, e, s, e / std::sqrt(s)};
+                return m_last;
+            }
+
+            T alpha() const {return m_alpha;}
+            T beta() const {return m_beta;}
+
+            // Output of the latest update
+            const BasicKalmanStep<T>& last() const {return m_last;}
+
+            // Entries (0, 0), (0, 1) and (1, 1) of the state covariance
+            T covAlpha() const {return m_p00;}
+            T covAlphaBeta() const {return m_p01;}
+            T covBeta() const {return m_p11;}
+
+            std::size_t count() const {return m_count;}
+
+        private:
+
+            T m_qa = 0.0; // process noise of alpha
+            T m_qb = 0.0; // process noise of beta
+            T m_r = 0.0; // observation noise
+
+            T m_alpha = 0.0;
+            T m_beta = 0.0;
+            // state covariance, uninformative prior
+            T m_p00 = 1.0;
+            T m_p01 = 0.0;
+            T m_p11 = 1.0;
+
+            std::size_t m_count = 0;
+            BasicKalmanStep<T> m_last{};
+    };
+
+    using KalmanRegression = BasicKalmanRegression<double>;
+}
+
+#endif // KALMANREGRESSION_H_
@@ -0,0 +1,121 @@
+#ifndef NESTEDOLS_H_
+#define NESTEDOLS_H_
+
+#include "solvers.hpp"
+#include "../../tools/instrumentation.hpp"
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace linModels {
+
+    // Information criteria and last column t-stat for every nested model X[:, :j]
+    // Vectors are indexed by the number of columns j, entries below the first
+    // requested width are left at zero.
+    template <typename T>
+    struct BasicNestedRegressionResult {
+        std::vector<T> rss;
+        std::vector<T> aic;
+        std::vector<T> bic;
+        std::vector<T> tLast; // t-value of column j - 1 in the model using j columns
+
+        std::size_t nobs = 0;
+    };
+
+    using NestedRegressionResult = BasicNestedRegressionResult<double>;
+
+    // OLS over all column prefixes of a design matrix from one factorization
+    //
+    // With the Householder QR X = QR, the first j columns of X factor as
+    // Q[:, :j] R[:j, :j]. Taking z = Q^{t}y the model on j columns then has
+    //
+    //     RSS_j = sum_{i >= j} z_i^2
+    //     t_j   = sign(R_{j-1,j-1}) z_{j-1} / sqrt(RSS_j / (n - j))
+    //
+    // so every candidate lag order is read off a single O(n k^2) factorization
+    // instead of refitting each prefix.
+    template <typename T>
+    class BasicNestedOLS {
+
+        public:
+
+            BasicNestedOLS() = default;
+
+            // Fits widths minCols, ..., maxCols (inclusive) of X (n, k)
+            template <typename EXPR, typename YEXPR>
+            inline const BasicNestedRegressionResult<T>& fit(const EXPR& X, const YEXPR& y, int minCols, int maxCols) {
+                const std::size_t n = X.shape(0);
+                if (minCols < 1 || maxCols < minCols || static_cast<std::size_t>(maxCols) > X.shape(1))
+                    throw std::invalid_argument("linModels::NestedOLS::fit : Invalid column range.");
+                if (static_cast<std::size_t>(maxCols) >= n)
+                    throw std::invalid_argument("linModels::NestedOLS::fit : Not enough observations.");
+
+                const std::size_t k = static_cast<std::size_t>(maxCols);
+                TSA_COUNT(nestedFits);
+
+                // column major copy of the used columns, factorized in place
+                m_qr.resize(n * k);
+                m_z.resize(n);
+                m_diag.resize(k);
+                m_tau.resize(k);
+                for (std::size_t j = 0; j < k; ++j) {
+                    T* col = m_qr.data() + j * n;
+                    for (std::size_t i = 0; i < n; ++i)
+                        col[i] = X(i, j);
+                }
+                for (std::size_t i = 0; i < n; ++i)
+                    m_z[i] = y(i);
+
+                solvers::householderQR(m_qr.data(), n, k, m_diag.data(), m_tau.data());
+                solvers::applyQt(m_qr.data(), n, k, m_tau.data(), m_z.data());
+
+                // tail sums of z^2 give the RSS of every prefix without cancellation
+                m_res.rss.assign(k + 1, 0.0);
+                m_res.aic.assign(k + 1, 0.0);
+                m_res.bic.assign(k + 1, 0.0);
+                m_res.tLast.assign(k + 1, 0.0);
+                m_res.nobs = n;
+
+                T tail = 0.0;
+                for (std::size_t i = n; i-- > k;)
+                    tail += m_z[i] * m_z[i];
+
+                const T dn = static_cast<T>(n);
+                for (std::size_t j = k; j >= static_cast<std::size_t>(minCols); --j) {
+                    const T rss = tail;
+                    const T dj = static_cast<T>(j);
+                    const T sigma2 = rss / (dn - dj);
+                    const T rjj = m_diag[j - 1];
+
+                    m_res.rss[j] = rss;
+                    m_res.aic[j] = dn * std::log(rss / dn) + 2.0 * dj;
+                    m_res.bic[j] = dn * std::log(rss / dn) + dj * std::log(dn);
+                    // a zero pivot means column j - 1 is collinear with the ones before it
+                    m_res.tLast[j] = (rjj == 0.0) ? 0.0
+                        : std::copysign(1.0, rjj) * m_z[j - 1] / std::sqrt(sigma2);
+
+                    tail += m_z[j - 1] * m_z[j - 1];
+                }
+
+                return m_res;
+            }
+
+            const BasicNestedRegressionResult<T>& getResult() const {return m_res;}
+
+        private:
+
+            std::vector<T> m_qr; // factorized copy of X
+            std::vector<T> m_z; // Q^{t}y
+            std::vector<T> m_diag; // diagonal of R
+            std::vector<T> m_tau; // Householder scales
+
+            BasicNestedRegressionResult<T> m_res;
+    };
+
+    using NestedOLS = BasicNestedOLS<double>;
+
+}
+
+#endif // NESTEDOLS_H_
@@ -0,0 +1,91 @@
+#ifndef OLSESTIMATOR_H_
+#define OLSESTIMATOR_H_
+
+#include "RegressionModel.hpp"
+#include "solvers.hpp"
+#include "../../tools/instrumentation.hpp"
+
+#include <cmath>
+#include <cstddef>
+
+namespace linModels {
+
+    // Non-owning Ordinary Least Squares
+    //
+    // Borrows X (n, k) and y (n) as any expression with shape() and element access,
+    // e.g. xt::view, xt::adapt over raw strided memory or a lazy design matrix, and
+    // never copies them. Results are written into a caller supplied RegressionResult
+    // whose tensors are only resized when the shape changes, and the factorization
+    // runs in the estimator's own workspace. Reusing one estimator and one result
+    // for fits of the same shape therefore does not allocate, and there is no
+    // virtual dispatch or heap allocated model per fit. T is the scalar type the
+    // factorization runs in and the results are stored as.
+    template <typename T>
+    class BasicOLSEstimator {
+
+        public:
+
+            explicit BasicOLSEstimator(solverType solver = QR) : m_solver(solver) {}
+
+            void setSolver(solverType solver) {m_solver.setSolver(solver);}
+
+            template <typename EX, typename EY>
+            inline void fit(const EX& X, const EY& y, BasicRegressionResult<T>& out) {
+                const std::size_t n = X.shape(0);
+                const std::size_t k = X.shape(1);
+
+                TSA_COUNT(olsFits);
+                m_solver.solve(X, y);
+
+                resize(out.params, k);
+                resize(out.stdErrors, k);
+                resize(out.tValues, k);
+                resize(out.fittedValues, n);
+                resize(out.residuals, n);
+
+                const std::vector<T>& beta = m_solver.params();
+                for (std::size_t j = 0; j < k; ++j)
+                    out.params(j) = beta[j];
+
+                // predictions, residuals and RSS in one sweep over the rows
+                T rss = 0.0;
+                for (std::size_t i = 0; i < n; ++i) {
+                    T fitted = 0.0;
+                    for (std::size_t j = 0; j < k; ++j)
+                        fitted += X(i, j) * beta[j];
+                    T e = y(i) - fitted;
+                    out.fittedValues(i) = fitted;
+                    out.residuals(i) = e;
+                    rss += e * e;
+                }
+
+                T sigma2 = rss / (n - k);
+
+                const std::vector<T>& covDiag = m_solver.covDiag();
+                for (std::size_t j = 0; j < k; ++j) {
+                    out.stdErrors(j) = std::sqrt(sigma2 * covDiag[j]);
+                    out.tValues(j) = out.params(j) / out.stdErrors(j);
+                }
+
+                // AIC and BIC
+                out.aic = n * std::log(rss / n) + 2 * k;
+                out.bic = n * std::log(rss / n) + k * std::log(n);
+
+                out.lag = static_cast<int>(k);
+            }
+
+        private:
+
+            static inline void resize(xt::xtensor<T, 1>& t, std::size_t n) {
+                if (t.size() != n)
+                    t.resize({n});
+            }
+
+            BasicLeastSquares<T> m_solver;
+    };
+
+    using OLSEstimator = BasicOLSEstimator<double>;
+
+}
+
+#endif // OLSESTIMATOR_H_
@@ -2,74 +2,65 @@
 #define OLS_H_
 
 #include "RegressionModel.hpp"
-
-#include <xtensor/core/xnoalias.hpp>
-#include <xtensor/containers/xadapt.hpp>
+#include "OLSEstimator.hpp"
+#include "solvers.hpp"
+#include "../../tools/lagMatrix.hpp"
 
 
 namespace linModels {
 
     // Ordinaray Least Squares model
 
-    class OLSModel : public RegressionModel {
+    template <typename T>
+    class BasicOLSModel : public BasicRegressionModel<T> {
 
         public:
 
-            using RegressionModel::RegressionModel;
+            // solver picks the factorization, see linModels::LeastSquares
+            template <typename EXPR>
+            BasicOLSModel(const EXPR& x, const xt::xtensor<T, 1>& y, solverType solver = QR)
+                : BasicRegressionModel<T>(x, y), m_est(solver) {};
+
+            // Borrows a lazy lag matrix and fits on it without materializing the design,
+            // x and the series it reads must outlive the model
+            BasicOLSModel(const tools::BasicLagMatrix<T>& x, const xt::xtensor<T, 1>& y, solverType solver = QR)
+                : BasicRegressionModel<T>(y), m_est(solver), m_lagX(&x) {};
+
+            void setSolver(solverType solver) {m_est.setSolver(solver);}
 
-            // Closed form solution working on X (n, k)
+            // Least squares solution working on X (n, k)
             // n observations
             // p features
-            inline RegressionResult fit() override {
-                // Transpose X (n, k) to Xt (k, n)
-                xt::xtensor<double, 2> Xt = xt::transpose(X);
-                // Compute X^{t}X with dot
-                xt::xtensor<double, 2> XtX = xt::linalg::dot(Xt, X);
-
-                // Before inversion must check that XtX is not singular
-                // This is done using the condition number
-                auto svd = xt::linalg::svd(XtX);
-                auto S = std::get<1>(svd);
-                double cond = S(0) / S(S.shape(0) - 1); // largest / smallest singular value
-                xt::xtensor<double, 2> XtXi;
-                if (cond > 1e12) {
-                    // matrix is near singular so must use Moore-Rose pseudo inverse
-                    xt::noalias(XtXi) = xt::linalg::pinv(XtX);
-                } else {
-                    xt::noalias(XtXi) = xt::linalg::inv(XtX);
-                }
-
-                // Compute X^{t}y with dot
-                xt::xtensor<double, 1> Xty = xt::linalg::dot(Xt, y);
-                // Calculate coefficients as dot(XtXi, Xty)
-                xt::noalias(params) = xt::linalg::dot(XtXi, Xty);
-                // Make predictions
-                xt::noalias(fittedValues) = xt::linalg::dot(X, params);
-                // Calculate residuals
-                xt::noalias(residuals) = y - fittedValues;
-
-                // Error metrics
-                double rss = xt::sum(xt::square(residuals))();
-                size_t n = X.shape(0);
-                size_t k = X.shape(1); // can be used for lag used
-                double sigma2 = rss / (n - k);
-
-                // Variance-covariance matrix
-                auto varBeta = sigma2 * XtXi;
-
-                // T-values
-                xt::noalias(tValues) = params / xt::sqrt(xt::diagonal(varBeta));
-
-                // AIC and BIC
-                aic = n * std::log(rss / n) + 2 * k;
-                bic = n * std::log(rss / n) + k * std::log(n);
-
-                lag = static_cast<int>(k);
-
-                return {params, fittedValues, residuals, tValues, aic, bic, lag};
+            inline BasicRegressionResult<T> fit() override {
+                // Coefficients and standard errors from a single factorization,
+                // the solver falls back to the SVD when X is near singular
+                if (m_lagX != nullptr)
+                    m_est.fit(*m_lagX, this->y, m_res);
+                else
+                    m_est.fit(this->X, this->y, m_res);
+
+                this->params = m_res.params;
+                this->fittedValues = m_res.fittedValues;
+                this->residuals = m_res.residuals;
+                this->tValues = m_res.tValues;
+                this->stdErrors = m_res.stdErrors;
+
+                this->aic = m_res.aic;
+                this->bic = m_res.bic;
+                this->lag = m_res.lag;
+
+                return m_res;
             }
+
+        private:
+
+            BasicOLSEstimator<T> m_est; // owns the factorization workspace across fits
+            BasicRegressionResult<T> m_res;
+            const tools::BasicLagMatrix<T>* m_lagX = nullptr; // borrowed design, X is unused when set
     };
 
+    using OLSModel = BasicOLSModel<double>;
+
 }
 
 #endif // OLS_H_
@@ -7,48 +7,64 @@
 
 namespace linModels {
 
-    struct RegressionResult {
-        xt::xtensor<double, 1> params;
-        xt::xtensor<double, 1> fittedValues;
-        xt::xtensor<double, 1> residuals;
-        xt::xtensor<double, 1> tValues;
+    // Coefficients and fit statistics, T is the scalar type
+    template <typename T>
+    struct BasicRegressionResult {
+        xt::xtensor<T, 1> params;
+        xt::xtensor<T, 1> fittedValues;
+        xt::xtensor<T, 1> residuals;
+        xt::xtensor<T, 1> tValues;
 
-        double aic = 0.0;
-        double bic = 0.0;
+        T aic = 0.0;
+        T bic = 0.0;
 
         int lag = -1;
+
+        xt::xtensor<T, 1> stdErrors;
     };
 
-    class RegressionModel {
+    using RegressionResult = BasicRegressionResult<double>;
+
+    template <typename T>
+    class BasicRegressionModel {
 
         protected:
-            xt::xtensor<double, 2> X;
-            xt::xtensor<double, 1> y;
-            xt::xtensor<double, 1> params; // model coefficients
-            xt::xtensor<double, 1> fittedValues; // The predicted values
-            xt::xtensor<double, 1> residuals; // residual error between true y and predicted
-            xt::xtensor<double, 1> tValues; // how significantly different coeffiecients are from zero
+            xt::xtensor<T, 2> X;
+            xt::xtensor<T, 1> y;
+            xt::xtensor<T, 1> params; // model coefficients
+            xt::xtensor<T, 1> fittedValues; // The predicted values
+            xt::xtensor<T, 1> residuals; // residual error between true y and predicted
+            xt::xtensor<T, 1> tValues; // how significantly different coeffiecients are from zero
+            xt::xtensor<T, 1> stdErrors; // standard errors of the coefficients
 
-            double aic; // Akaike information criterion
-            double bic; // Bayesian information criterion
+            T aic; // Akaike information criterion
+            T bic; // Bayesian information criterion
 
             int lag; // Lag length used
 
         public:
             // x passed from xt::view which gives expression
             template <typename EXPR>
-            RegressionModel(const EXPR& x, const xt::xtensor<double, 1>& y)
+            BasicRegressionModel(const EXPR& x, const xt::xtensor<T, 1>& y)
                 : X(x), y(y) {};
 
-            virtual ~RegressionModel() = default;
+        protected:
+            // For models that borrow their design rather than holding it in X
+            explicit BasicRegressionModel(const xt::xtensor<T, 1>& y) : y(y) {};
+
+        public:
+            virtual ~BasicRegressionModel() = default;
 
-            virtual RegressionResult fit() = 0;
+            virtual BasicRegressionResult<T> fit() = 0;
 
-            xt::xtensor<double, 1> getParams() const {return params;}
-            xt::xtensor<double, 1> getFitted() const {return fittedValues;}
-            xt::xtensor<double, 1> getResiduals() const {return residuals;}
+            xt::xtensor<T, 1> getParams() const {return params;}
+            xt::xtensor<T, 1> getFitted() const {return fittedValues;}
+            xt::xtensor<T, 1> getResiduals() const {return residuals;}
+            xt::xtensor<T, 1> getStdErrors() const {return stdErrors;}
     };
 
+    using RegressionModel = BasicRegressionModel<double>;
+
 }
 
 #endif // REGRESSIONMODEL_H_
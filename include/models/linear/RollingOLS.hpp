@@ -0,0 +1,298 @@
+#ifndef ROLLINGOLS_H_
+#define ROLLINGOLS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "solvers.hpp"
+
+namespace linModels {
+
+    // Ordinary Least Squares over a sliding window of observations
+    //
+    // Keeps X^{t}X, X^{t}y and y^{t}y of the window together with (X^{t}X)^{-1}.
+    // A tick adds the newest row and removes the oldest one as two Sherman-Morrison
+    // rank one updates of the inverse, so the coefficients, standard errors,
+    // t-values and RSS cost O(k^2) per tick instead of a refit. The sums and the
+    // inverse are rebuilt from the window by Cholesky once every window length
+    // ticks, or sooner when a removal is ill conditioned, to bound rounding drift.
+    // With a constant the sums are taken about the window means of the rebuild, as
+    // for the rolling statistics, so price level regressors do not square the
+    // condition number; the intercept and its standard error are mapped back.
+    //
+    // With constant true a column of ones is prepended to the regressors passed to
+    // update and reported first. Results are NaN until the window is full or while
+    // the window's design is singular.
+    template <typename T>
+    class BasicRollingOLS {
+
+        public:
+
+            BasicRollingOLS(std::size_t nRegressors, std::size_t window, bool constant = true)
+                : m_p(nRegressors), m_k(nRegressors + (constant ? 1 : 0)), m_ws(window), m_constant(constant) {
+                if (m_k == 0)
+                    throw std::invalid_argument("linModels::RollingOLS : At least one regressor is required.");
+                if (m_ws <= m_k)
+                    throw std::invalid_argument("linModels::RollingOLS : Window must be longer than the number of regressors.");
+
+                m_X.resize(m_ws * m_k);
+                m_y.resize(m_ws);
+                m_G.resize(m_k * m_k);
+                m_b.resize(m_k);
+                m_inv.resize(m_k * m_k);
+                m_ref.assign(m_k, 0.0);
+                m_w.resize(m_k);
+                m_z.resize(m_k);
+                m_u.resize(m_k);
+
+                const T nan = std::numeric_limits<T>::quiet_NaN();
+                m_params.assign(m_k, nan);
+                m_stdErrors.assign(m_k, nan);
+                m_tValues.assign(m_k, nan);
+            }
+
+            // Adds the observation (x, y), x holding nRegressors values, and refits the window.
+            // Returns true once the results are valid.
+            bool update(const T* x, T y) {
+                std::size_t slot = m_head;
+                if (++m_head == m_ws)
+                    m_head = 0;
+
+                T* row = m_X.data() + slot * m_k;
+                const bool full = m_count == m_ws;
+
+                // the slot being overwritten holds the oldest row, take it out of the sums
+                if (full) {
+                    center(row, m_z.data());
+                    accumulate(m_z.data(), m_y[slot] - m_yRef, -1.0);
+                } else {
+                    ++m_count;
+                }
+
+                if (m_constant)
+                    row[0] = 1.0;
+                std::copy(x, x + m_p, row + (m_k - m_p));
+                m_y[slot] = y;
+                center(row, m_w.data());
+                accumulate(m_w.data(), y - m_yRef, 1.0);
+
+                if (m_count < m_ws)
+                    return false;
+
+                if (!full || !m_valid || ++m_ticks >= m_ws) {
+                    refresh();
+                } else {
+                    // add the new row before removing the old one so the inverse stays positive definite
+                    m_valid = shermanMorrison(m_w.data(), 1.0);
+                    if (m_valid)
+                        m_valid = shermanMorrison(m_z.data(), -1.0);
+                    if (!m_valid)
+                        refresh();
+                }
+
+                solve();
+                return m_valid;
+            }
+
+            // Single regressor convenience, e.g. a hedge ratio
+            bool update(T x, T y) {
+                if (m_p != 1)
+                    throw std::invalid_argument("linModels::RollingOLS::update : Expected nRegressors values.");
+                return update(&x, y);
+            }
+
+            bool ready() const {return m_valid && m_count == m_ws;}
+
+            // Coefficients, the constant first when included
+            const std::vector<T>& params() const {return m_params;}
+            const std::vector<T>& stdErrors() const {return m_stdErrors;}
+            const std::vector<T>& tValues() const {return m_tValues;}
+            T rss() const {return m_rss;}
+
+            std::size_t window() const {return m_ws;}
+            std::size_t regressors() const {return m_k;}
+
+        private:
+
+            // Row about the reference levels
+            void center(const T* row, T* out) const {
+                for (std::size_t a = 0; a < m_k; ++a)
+                    out[a] = row[a] - m_ref[a];
+            }
+
+            // Adds sign * (z z^{t}, z y, y^2) to the sums
+            void accumulate(const T* z, T y, T sign) {
+                for (std::size_t a = 0; a < m_k; ++a) {
+                    T za = sign * z[a];
+                    for (std::size_t c = 0; c < m_k; ++c)
+                        m_G[a * m_k + c] += za * z[c];
+                    m_b[a] += za * y;
+                }
+                m_yty += sign * y * y;
+            }
+
+            // (A + sign z z^{t})^{-1} from A^{-1}, false when the update is ill conditioned
+            bool shermanMorrison(const T* z, T sign) {
+                const std::size_t k = m_k;
+                T ztu = 0.0;
+                for (std::size_t a = 0; a < k; ++a) {
+                    T s = 0.0;
+                    for (std::size_t c = 0; c < k; ++c)
+                        s += m_inv[a * k + c] * z[c];
+                    m_u[a] = s;
+                    ztu += z[a] * s;
+                }
+
+                // for a removal 1 - z^{t}A^{-1}z is one minus the row's leverage
+                const T denom = 1.0 + sign * ztu;
+                if (!(denom > std::sqrt(std::numeric_limits<T>::epsilon())))
+                    return false;
+
+                const T scale = sign / denom;
+                for (std::size_t a = 0; a < k; ++a) {
+                    T ua = scale * m_u[a];
+                    for (std::size_t c = 0; c < k; ++c)
+                        m_inv[a * k + c] -= ua * m_u[c];
+                }
+                return true;
+            }
+
+            // Rebuilds the sums from the window and inverts X^{t}X by Cholesky
+            void refresh() {
+                const std::size_t k = m_k;
+                if (m_constant) {
+                    std::fill(m_ref.begin(), m_ref.end(), 0.0);
+                    m_yRef = 0.0;
+                    for (std::size_t r = 0; r < m_ws; ++r) {
+                        for (std::size_t a = 1; a < k; ++a)
+                            m_ref[a] += m_X[r * k + a];
+                        m_yRef += m_y[r];
+                    }
+                    for (std::size_t a = 1; a < k; ++a)
+                        m_ref[a] /= static_cast<T>(m_ws);
+                    m_yRef /= static_cast<T>(m_ws);
+                }
+
+                std::fill(m_G.begin(), m_G.end(), 0.0);
+                std::fill(m_b.begin(), m_b.end(), 0.0);
+                m_yty = 0.0;
+                for (std::size_t r = 0; r < m_ws; ++r) {
+                    center(m_X.data() + r * k, m_w.data());
+                    accumulate(m_w.data(), m_y[r] - m_yRef, 1.0);
+                }
+
+                m_ticks = 0;
+
+                m_L.assign(m_G.begin(), m_G.end());
+                m_valid = solvers::cholesky(m_L.data(), k);
+                if (!m_valid)
+                    return;
+
+                // pivot ratio squared approximates the condition number of X^{t}X
+                T lmax = 0.0, lmin = std::numeric_limits<T>::infinity();
+                for (std::size_t j = 0; j < k; ++j) {
+                    lmax = std::max(lmax, m_L[j * k + j]);
+                    lmin = std::min(lmin, m_L[j * k + j]);
+                }
+                if ((lmax / lmin) * (lmax / lmin) > solvers::condLimitOf<T>) {
+                    m_valid = false;
+                    return;
+                }
+
+                // one column of the inverse per unit vector, O(k^3) once per window
+                for (std::size_t j = 0; j < m_k; ++j) {
+                    std::fill(m_u.begin(), m_u.end(), 0.0);
+                    m_u[j] = 1.0;
+                    solvers::forwardSubst(m_L.data(), m_k, m_u.data());
+                    solvers::backSubstT(m_L.data(), m_k, m_u.data());
+                    for (std::size_t a = 0; a < m_k; ++a)
+                        m_inv[a * m_k + j] = m_u[a];
+                }
+            }
+
+            // Coefficients and statistics from the inverse and the sums
+            void solve() {
+                const std::size_t k = m_k;
+                if (!m_valid) {
+                    const T nan = std::numeric_limits<T>::quiet_NaN();
+                    std::fill(m_params.begin(), m_params.end(), nan);
+                    std::fill(m_stdErrors.begin(), m_stdErrors.end(), nan);
+                    std::fill(m_tValues.begin(), m_tValues.end(), nan);
+                    m_rss = nan;
+                    return;
+                }
+
+                T btb = 0.0;
+                for (std::size_t a = 0; a < k; ++a) {
+                    T s = 0.0;
+                    for (std::size_t c = 0; c < k; ++c)
+                        s += m_inv[a * k + c] * m_b[c];
+                    m_params[a] = s;
+                    btb += s * m_b[a];
+                }
+
+                // RSS = y^{t}y - beta^{t}X^{t}y, unchanged by the centering
+                m_rss = std::max(m_yty - btb, T(0));
+                const T sigma2 = m_rss / static_cast<T>(m_ws - k);
+                for (std::size_t a = 0; a < k; ++a)
+                    m_stdErrors[a] = std::sqrt(sigma2 * m_inv[a * k + a]);
+
+                if (m_constant) {
+                    // intercept = v^{t}beta + yRef with v = (1, -ref), its variance sigma^2 v^{t}(X^{t}X)^{-1}v
+                    T c = m_yRef;
+                    T var = 0.0;
+                    for (std::size_t a = 0; a < k; ++a) {
+                        T va = (a == 0) ? T(1) : -m_ref[a];
+                        c += va * m_params[a];
+                        T s = 0.0;
+                        for (std::size_t b = 0; b < k; ++b)
+                            s += m_inv[a * k + b] * ((b == 0) ? T(1) : -m_ref[b]);
+                        var += va * s;
+                    }
+                    m_params[0] = c;
+                    m_stdErrors[0] = std::sqrt(sigma2 * std::max(var, T(0)));
+                }
+
+                for (std::size_t a = 0; a < k; ++a)
+                    m_tValues[a] = m_params[a] / m_stdErrors[a];
+            }
+
+            std::size_t m_p; // regressors passed to update
+            std::size_t m_k; // columns including the constant
+            std::size_t m_ws;
+            bool m_constant;
+
+            std::vector<T> m_X; // window rows, ring of (ws, k)
+            std::vector<T> m_y;
+            std::size_t m_head = 0; // slot of the next row
+            std::size_t m_count = 0; // rows in the window
+
+            std::vector<T> m_G; // X^{t}X, row major (k, k)
+            std::vector<T> m_b; // X^{t}y
+            T m_yty = 0.0;
+            std::vector<T> m_inv; // (X^{t}X)^{-1}
+            std::vector<T> m_L; // Cholesky scratch for refresh
+
+            std::vector<T> m_ref; // reference levels of the regressors, zero for the constant
+            T m_yRef = 0.0; // reference level of y
+            std::vector<T> m_w; // centered new row
+            std::vector<T> m_z; // centered evicted row
+            std::vector<T> m_u; // A^{-1} z
+
+            std::vector<T> m_params;
+            std::vector<T> m_stdErrors;
+            std::vector<T> m_tValues;
+            T m_rss = std::numeric_limits<T>::quiet_NaN();
+
+            bool m_valid = false;
+            std::size_t m_ticks = 0; // ticks since the last refresh
+    };
+
+    using RollingOLS = BasicRollingOLS<double>;
+}
+
+#endif // ROLLINGOLS_H_
@@ -4,16 +4,20 @@
 #include "RegressionModel.hpp"
 #include "OLSModel.hpp"
 
+#include <memory>
+#include <stdexcept>
+
 namespace linModels {
 
     enum modelType {
         OLS
     };
 
-    inline std::unique_ptr<RegressionModel> getModelOfType(modelType t, const xt::xtensor<double, 2>& X, const xt::xtensor<double, 1>& y) {
+    template <typename T>
+    inline std::unique_ptr<BasicRegressionModel<T>> getModelOfType(modelType t, const xt::xtensor<T, 2>& X, const xt::xtensor<T, 1>& y) {
         switch(t) {
             case OLS:
-                return std::make_unique<OLSModel>(X, y);
+                return std::make_unique<BasicOLSModel<T>>(X, y);
                 break;
             default:
                 throw std::invalid_argument("modelHelpers::getModelOfType : Invalid model type.");
@@ -0,0 +1,390 @@
+#ifndef SOLVERS_H_
+#define SOLVERS_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <vector>
+
+#include <xtensor/containers/xtensor.hpp>
+#include <xtensor-blas/xlinalg.hpp>
+
+namespace linModels {
+
+    // Factorization used to solve the least squares problem
+    enum solverType {
+        CHOLESKY, // normal equations, fastest, for well conditioned X
+        QR, // Householder QR on X, default
+        SVD // singular value decomposition, handles rank deficient X
+    };
+
+    namespace solvers {
+
+        // Condition number of X^{t}X above which a fit falls back to the SVD
+        template <typename T>
+        inline constexpr double condLimitOf = 1e12;
+        template <>
+        inline constexpr double condLimitOf<float> = 1e6;
+
+        const double condLimit = condLimitOf<double>;
+
+        // Accumulates the lower triangle of X^{t}X into the row major (k, k) G and X^{t}y
+        // into b, in one sweep over the rows of any expression with element access
+        template <typename EX, typename EY, typename T>
+        inline void normalEquations(const EX& X, const EY& y, T* G, T* b) {
+            const std::size_t n = X.shape(0);
+            const std::size_t k = X.shape(1);
+
+            std::fill(G, G + k * k, 0.0);
+            std::fill(b, b + k, 0.0);
+            for (std::size_t i = 0; i < n; ++i) {
+                const T yi = y(i);
+                for (std::size_t a = 0; a < k; ++a) {
+                    const T xa = X(i, a);
+                    for (std::size_t c = 0; c <= a; ++c)
+                        G[a * k + c] += xa * X(i, c);
+                    b[a] += xa * yi;
+                }
+            }
+        }
+
+        // In place Cholesky of the row major symmetric (k, k) matrix A, the lower
+        // triangle is overwritten by L with A = L L^{t}. Returns false when A is not
+        // numerically positive definite.
+        template <typename T>
+        inline bool cholesky(T* A, std::size_t k) {
+            for (std::size_t j = 0; j < k; ++j) {
+                T d = A[j * k + j];
+                for (std::size_t p = 0; p < j; ++p)
+                    d -= A[j * k + p] * A[j * k + p];
+                if (!(d > 0.0))
+                    return false;
+                T ljj = std::sqrt(d);
+                A[j * k + j] = ljj;
+                for (std::size_t i = j + 1; i < k; ++i) {
+                    T s = A[i * k + j];
+                    for (std::size_t p = 0; p < j; ++p)
+                        s -= A[i * k + p] * A[j * k + p];
+                    A[i * k + j] = s / ljj;
+                }
+            }
+            return true;
+        }
+
+        // Rank one update of the row major lower triangular L to the factor of L L^{t} + x x^{t}
+        //
+        // One Givens rotation per column, the rows below the diagonal are independent
+        // so the inner loop carries no dependency chain. x is consumed. O(k^2).
+        //
+        // A zero pivot is a column no row has reached yet, there the rotation is a
+        // swap, so starting from L = 0 and adding rows one at a time builds the R of
+        // a QR factorization of the stacked rows.
+        template <typename T>
+        inline void cholUpdate(T* L, std::size_t k, T* x) {
+            for (std::size_t j = 0; j < k; ++j) {
+                T ljj = L[j * k + j];
+                if (ljj == 0.0) {
+                    if (x[j] == 0.0)
+                        continue;
+                    T sg = x[j] > 0.0 ? T(1) : T(-1);
+                    L[j * k + j] = std::abs(x[j]);
+                    for (std::size_t i = j + 1; i < k; ++i) {
+                        T l = L[i * k + j];
+                        L[i * k + j] = sg * x[i];
+                        x[i] = -sg * l;
+                    }
+                    continue;
+                }
+                // plain sqrt rather than hypot, the squares overflow no sooner than a Gram matrix would
+                T r = std::sqrt(ljj * ljj + x[j] * x[j]);
+                T c = r / ljj;
+                T s = x[j] / ljj;
+                T cinv = ljj / r;
+                L[j * k + j] = r;
+                for (std::size_t i = j + 1; i < k; ++i) {
+                    T l = (L[i * k + j] + s * x[i]) * cinv;
+                    x[i] = c * x[i] - s * l;
+                    L[i * k + j] = l;
+                }
+            }
+        }
+
+        // Solves L x = b in place for the row major lower triangular L
+        template <typename T>
+        inline void forwardSubst(const T* L, std::size_t k, T* b) {
+            for (std::size_t i = 0; i < k; ++i) {
+                T s = b[i];
+                for (std::size_t p = 0; p < i; ++p)
+                    s -= L[i * k + p] * b[p];
+                b[i] = s / L[i * k + i];
+            }
+        }
+
+        // Solves L^{t} x = b in place for the row major lower triangular L
+        template <typename T>
+        inline void backSubstT(const T* L, std::size_t k, T* b) {
+            for (std::size_t i = k; i-- > 0;) {
+                T s = b[i];
+                for (std::size_t p = i + 1; p < k; ++p)
+                    s -= L[p * k + i] * b[p];
+                b[i] = s / L[i * k + i];
+            }
+        }
+
+        // In place Householder QR of the column major (n, k) matrix A
+        //
+        // On return the strict upper triangle of A holds R, diag holds the diagonal
+        // of R, and column j of A from row j down holds the reflector v_j with
+        // H_j = I - tau_j v_j v_j^{t}. A zero column gives tau_j = 0 and R_jj = 0.
+        template <typename T>
+        inline void householderQR(T* A, std::size_t n, std::size_t k, T* diag, T* tau) {
+            for (std::size_t j = 0; j < k; ++j) {
+                T* v = A + j * n;
+
+                T norm2 = 0.0;
+                for (std::size_t i = j; i < n; ++i)
+                    norm2 += v[i] * v[i];
+
+                if (norm2 == 0.0) {
+                    diag[j] = 0.0;
+                    tau[j] = 0.0;
+                    continue;
+                }
+
+                const T norm = std::sqrt(norm2);
+                const T alpha = (v[j] > 0.0) ? -norm : norm;
+                const T v0 = v[j] - alpha;
+                // ||v||^2 with v = x - alpha e_j
+                const T vnorm2 = norm2 - v[j] * v[j] + v0 * v0;
+                v[j] = v0;
+                diag[j] = alpha;
+                tau[j] = 2.0 / vnorm2;
+
+                for (std::size_t l = j + 1; l < k; ++l) {
+                    T* a = A + l * n;
+                    T s = 0.0;
+                    for (std::size_t i = j; i < n; ++i)
+                        s += v[i] * a[i];
+                    s *= tau[j];
+                    for (std::size_t i = j; i < n; ++i)
+                        a[i] -= s * v[i];
+                }
+            }
+        }
+
+        // Overwrites z (n) with Q^{t}z using the reflectors left by householderQR
+        template <typename T>
+        inline void applyQt(const T* A, std::size_t n, std::size_t k, const T* tau, T* z) {
+            for (std::size_t j = 0; j < k; ++j) {
+                if (tau[j] == 0.0)
+                    continue;
+                const T* v = A + j * n;
+                T s = 0.0;
+                for (std::size_t i = j; i < n; ++i)
+                    s += v[i] * z[i];
+                s *= tau[j];
+                for (std::size_t i = j; i < n; ++i)
+                    z[i] -= s * v[i];
+            }
+        }
+
+        // Solves R x = b in place for the R left in A (column major, leading dim n) and diag
+        template <typename T>
+        inline void backSubstR(const T* A, std::size_t n, std::size_t k, const T* diag, T* b) {
+            for (std::size_t i = k; i-- > 0;) {
+                T s = b[i];
+                for (std::size_t p = i + 1; p < k; ++p)
+                    s -= A[i + p * n] * b[p];
+                b[i] = s / diag[i];
+            }
+        }
+
+    }
+
+    // Least squares solver owning its factorization workspace
+    //
+    // Buffers grow to the largest shape seen and are reused afterwards, so repeated
+    // fits of the same shape do not allocate. The diagonal of (X^{t}X)^{-1}, used for
+    // the standard errors, comes from the same factorization as the coefficients:
+    //
+    //     CHOLESKY : X^{t}X = L L^{t},  (X^{t}X)^{-1} = L^{-t} L^{-1}
+    //     QR       : X = QR,            (X^{t}X)^{-1} = R^{-1} R^{-t}
+    //     SVD      : X = U S V^{t},     (X^{t}X)^{-1} = V S^{-2} V^{t}
+    //
+    // Cholesky and QR fall back to the SVD when the problem is near singular.
+    // T is the scalar type of the workspace and the results.
+    template <typename T>
+    class BasicLeastSquares {
+
+        public:
+
+            explicit BasicLeastSquares(solverType solver = QR) : m_solver(solver) {}
+
+            void setSolver(solverType solver) {m_solver = solver;}
+            solverType getSolver() const {return m_solver;}
+
+            // Solves min ||y - X b|| for X (n, k), returns the solver actually used
+            template <typename EX, typename EY>
+            inline solverType solve(const EX& X, const EY& y) {
+                const std::size_t n = X.shape(0);
+                const std::size_t k = X.shape(1);
+
+                m_params.resize(k);
+                m_covDiag.resize(k);
+
+                if (m_solver == CHOLESKY && solveCholesky(X, y, n, k))
+                    return CHOLESKY;
+                if (m_solver == QR && solveQR(X, y, n, k))
+                    return QR;
+
+                solveSVD(X, y, n, k);
+                return SVD;
+            }
+
+            const std::vector<T>& params() const {return m_params;}
+            // diagonal of (X^{t}X)^{-1}
+            const std::vector<T>& covDiag() const {return m_covDiag;}
+
+        private:
+
+            template <typename EX, typename EY>
+            inline bool solveCholesky(const EX& X, const EY& y, std::size_t, std::size_t k) {
+                m_a.resize(k * k);
+                m_b.resize(k);
+                solvers::normalEquations(X, y, m_a.data(), m_b.data());
+
+                if (!solvers::cholesky(m_a.data(), k))
+                    return false;
+
+                // pivot ratio squared approximates the condition number of X^{t}X
+                T lmax = 0.0, lmin = std::numeric_limits<T>::infinity();
+                for (std::size_t j = 0; j < k; ++j) {
+                    lmax = std::max(lmax, m_a[j * k + j]);
+                    lmin = std::min(lmin, m_a[j * k + j]);
+                }
+                if ((lmax / lmin) * (lmax / lmin) > solvers::condLimitOf<T>)
+                    return false;
+
+                solvers::forwardSubst(m_a.data(), k, m_b.data());
+                solvers::backSubstT(m_a.data(), k, m_b.data());
+                std::copy(m_b.begin(), m_b.end(), m_params.begin());
+
+                // diag of L^{-t} L^{-1} from the columns of L^{-1}
+                std::fill(m_covDiag.begin(), m_covDiag.end(), 0.0);
+                m_e.resize(k);
+                for (std::size_t c = 0; c < k; ++c) {
+                    std::fill(m_e.begin(), m_e.end(), 0.0);
+                    m_e[c] = 1.0;
+                    // L^{-1} e_c is zero above row c
+                    for (std::size_t i = c; i < k; ++i) {
+                        T s = m_e[i];
+                        for (std::size_t p = c; p < i; ++p)
+                            s -= m_a[i * k + p] * m_e[p];
+                        m_e[i] = s / m_a[i * k + i];
+                    }
+                    // (L^{-t} L^{-1})_{cc} is the squared norm of column c of L^{-1}
+                    for (std::size_t i = c; i < k; ++i)
+                        m_covDiag[c] += m_e[i] * m_e[i];
+                }
+                return true;
+            }
+
+            template <typename EX, typename EY>
+            inline bool solveQR(const EX& X, const EY& y, std::size_t n, std::size_t k) {
+                if (n < k)
+                    return false;
+
+                m_a.resize(n * k);
+                m_b.resize(n);
+                m_diag.resize(k);
+                m_tau.resize(k);
+
+                for (std::size_t j = 0; j < k; ++j) {
+                    T* col = m_a.data() + j * n;
+                    for (std::size_t i = 0; i < n; ++i)
+                        col[i] = X(i, j);
+                }
+                for (std::size_t i = 0; i < n; ++i)
+                    m_b[i] = y(i);
+
+                solvers::householderQR(m_a.data(), n, k, m_diag.data(), m_tau.data());
+
+                T rmax = 0.0, rmin = std::numeric_limits<T>::infinity();
+                for (std::size_t j = 0; j < k; ++j) {
+                    rmax = std::max(rmax, std::abs(m_diag[j]));
+                    rmin = std::min(rmin, std::abs(m_diag[j]));
+                }
+                if (rmin == 0.0 || (rmax / rmin) * (rmax / rmin) > solvers::condLimitOf<T>)
+                    return false;
+
+                solvers::applyQt(m_a.data(), n, k, m_tau.data(), m_b.data());
+                solvers::backSubstR(m_a.data(), n, k, m_diag.data(), m_b.data());
+                std::copy(m_b.begin(), m_b.begin() + k, m_params.begin());
+
+                // (R^{-1} R^{-t})_{ii} is the squared norm of row i of R^{-1}, accumulated
+                // over its columns R^{-1} e_c, which are zero below row c
+                std::fill(m_covDiag.begin(), m_covDiag.end(), 0.0);
+                m_e.resize(k);
+                for (std::size_t c = 0; c < k; ++c) {
+                    for (std::size_t i = c + 1; i-- > 0;) {
+                        T s = (i == c) ? 1.0 : 0.0;
+                        for (std::size_t p = i + 1; p <= c; ++p)
+                            s -= m_a[i + p * n] * m_e[p];
+                        m_e[i] = s / m_diag[i];
+                        m_covDiag[i] += m_e[i] * m_e[i];
+                    }
+                }
+                return true;
+            }
+
+            // Moore-Penrose solution, singular values below the LAPACK style cutoff are dropped
+            template <typename EX, typename EY>
+            inline void solveSVD(const EX& X, const EY& y, std::size_t n, std::size_t k) {
+                xt::xtensor<T, 2> Xc = xt::empty<T>({n, k});
+                for (std::size_t i = 0; i < n; ++i)
+                    for (std::size_t j = 0; j < k; ++j)
+                        Xc(i, j) = X(i, j);
+
+                auto svd = xt::linalg::svd(Xc, false);
+                const auto& U = std::get<0>(svd);
+                const auto& S = std::get<1>(svd);
+                const auto& Vt = std::get<2>(svd);
+
+                const std::size_t r = S.shape(0);
+                const T cutoff = (r > 0 ? S(0) : 0.0) * static_cast<T>(std::max(n, k))
+                    * std::numeric_limits<T>::epsilon();
+
+                std::fill(m_params.begin(), m_params.end(), 0.0);
+                std::fill(m_covDiag.begin(), m_covDiag.end(), 0.0);
+                for (std::size_t s = 0; s < r; ++s) {
+                    if (S(s) <= cutoff)
+                        continue;
+                    T uty = 0.0;
+                    for (std::size_t i = 0; i < n; ++i)
+                        uty += U(i, s) * y(i);
+                    const T inv = 1.0 / S(s);
+                    for (std::size_t j = 0; j < k; ++j) {
+                        m_params[j] += Vt(s, j) * uty * inv;
+                        m_covDiag[j] += Vt(s, j) * Vt(s, j) * inv * inv;
+                    }
+                }
+            }
+
+            solverType m_solver;
+
+            std::vector<T> m_a; // factorized matrix
+            std::vector<T> m_b; // right hand side
+            std::vector<T> m_diag; // diagonal of R
+            std::vector<T> m_tau; // Householder scales
+            std::vector<T> m_e; // unit vector solves
+
+            std::vector<T> m_params;
+            std::vector<T> m_covDiag;
+    };
+
+    using LeastSquares = BasicLeastSquares<double>;
+
+}
+
+#endif // SOLVERS_H_
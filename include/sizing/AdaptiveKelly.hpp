@@ -0,0 +1,161 @@
+#ifndef ADAPTIVEKELLY_H_
+#define ADAPTIVEKELLY_H_
+
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <stdexcept>
+
+#include "KellyCriterion.hpp"
+#include "tradeLog.hpp"
+
+namespace sizing {
+
+    // Kelly fraction over the most recent trades
+    //
+    // recordWin and recordLoss may be called from any number of threads and never
+    // block, wins are logged as positive and losses as negative values. getKelly scans
+    // the window, trades still being written by another thread are left out of that
+    // read and counted by the next one. A trade whose writer was preempted for a full
+    // lap of the window is lost, see TradeLog.
+    class WindowedKelly {
+
+        public:
+
+            explicit WindowedKelly(std::size_t window) : m_log(window) {}
+
+            void recordWin(double profit) {
+                if (profit <= 0.0)
+                    throw std::invalid_argument("Win must have positive profit");
+                m_log.push(profit);
+            }
+
+            void recordLoss(double loss) {
+                if (loss <= 0.0)
+                    throw std::invalid_argument("Loss must be positive");
+                m_log.push(-loss);
+            }
+
+            double getKelly() const {
+                const std::uint64_t end = m_log.end();
+                const std::uint64_t n = std::min<std::uint64_t>(end, m_log.capacity());
+
+                double winSum = 0.0, lossSum = 0.0;
+                std::size_t nWins = 0, nLosses = 0;
+                for (std::uint64_t t = end - n; t < end; ++t) {
+                    double v;
+                    if (m_log.read(t, v) != slotState::READY)
+                        continue;
+                    if (v > 0.0) {
+                        ++nWins;
+                        winSum += v;
+                    } else {
+                        ++nLosses;
+                        lossSum -= v;
+                    }
+                }
+
+                return kellyFraction(static_cast<double>(nWins), winSum, static_cast<double>(nLosses), lossSum);
+            }
+
+            std::size_t window() const {return m_log.capacity();}
+
+        private:
+
+            TradeLog m_log;
+    };
+
+    // Kelly fraction with exponentially decaying trade weights
+    //
+    // Each recorded trade scales the weight of every earlier trade by lambda, so
+    // the effective memory is about 1 / (1 - lambda) trades. Recording only appends
+    // to a lock free log and never blocks. getKelly drains the log in ticket order
+    // into the decayed sums under a mutex that only readers take. If writers run
+    // more than capacity trades ahead of the reader the oldest undrained trades are
+    // dropped, although they still age the sums. A capacity well above 1 / (1 - lambda)
+    // makes the loss negligible.
+    class DecayedKelly {
+
+        public:
+
+            DecayedKelly(double lambda, std::size_t capacity = 4096) : m_lambda(lambda), m_log(capacity) {
+                if (!(lambda > 0.0 && lambda <= 1.0))
+                    throw std::invalid_argument("sizing::DecayedKelly : Lambda must be in (0, 1].");
+            }
+
+            void recordWin(double profit) {
+                if (profit <= 0.0)
+                    throw std::invalid_argument("Win must have positive profit");
+                m_log.push(profit);
+            }
+
+            void recordLoss(double loss) {
+                if (loss <= 0.0)
+                    throw std::invalid_argument("Loss must be positive");
+                m_log.push(-loss);
+            }
+
+            double getKelly() {
+                std::lock_guard<std::mutex> lock(m_readMutex);
+                drain();
+                return kellyFraction(m_nWins, m_winSum, m_nLosses, m_lossSum);
+            }
+
+            double lambda() const {return m_lambda;}
+
+        private:
+
+            void age(double factor) {
+                m_winSum *= factor;
+                m_lossSum *= factor;
+                m_nWins *= factor;
+                m_nLosses *= factor;
+            }
+
+            // Folds published trades into the sums, stopping at the first one still in flight.
+            // PENDING is always transient, a trade lost to a lapping writer reads as
+            // OVERWRITTEN and only ages the sums.
+            void drain() {
+                const std::uint64_t end = m_log.end();
+
+                if (end - m_next > m_log.capacity()) {
+                    const std::uint64_t skipped = end - m_log.capacity() - m_next;
+                    age(std::pow(m_lambda, static_cast<double>(skipped)));
+                    m_next += skipped;
+                }
+
+                for (; m_next < end; ++m_next) {
+                    double v;
+                    slotState st = m_log.read(m_next, v);
+                    if (st == slotState::PENDING)
+                        break;
+
+                    age(m_lambda);
+                    if (st == slotState::OVERWRITTEN)
+                        continue; // lapped while draining or lost
+                    if (v > 0.0) {
+                        m_nWins += 1.0;
+                        m_winSum += v;
+                    } else {
+                        m_nLosses += 1.0;
+                        m_lossSum -= v;
+                    }
+                }
+            }
+
+            double m_lambda;
+            TradeLog m_log;
+
+            std::mutex m_readMutex;
+            std::uint64_t m_next = 0; // next ticket to drain
+
+            // decayed weights and sums
+            double m_winSum = 0.0;
+            double m_lossSum = 0.0;
+            double m_nWins = 0.0;
+            double m_nLosses = 0.0;
+    };
+}
+
+#endif // ADAPTIVEKELLY_H_
@@ -5,6 +5,22 @@
 
 namespace sizing {
 
+    // Kelly fraction W - (1 - W) / R from the win probability and the average win and loss
+    //
+    // The counts may be fractional, e.g. exponentially weighted. Returns 0 when
+    // either side has no weight, as there is not enough data.
+    inline double kellyFraction(double nWins, double winSum, double nLosses, double lossSum) {
+        if (nWins <= 0.0 || nLosses <= 0.0)
+            return 0.0; // not enough data
+
+        double W = nWins / (nWins + nLosses);
+        double avgWin = winSum / nWins;
+        double avgLoss = lossSum / nLosses;
+        double R = avgWin / avgLoss;
+
+        return W - ((1.0 - W) / R);
+    }
+
     class Kelly {
 
         public:
@@ -26,16 +42,7 @@ namespace sizing {
             }
 
             double getKelly() {
-                int total = m_nWins + m_nLosses;
-                if (total == 0 || m_nWins == 0 || m_nLosses == 0)
-                    return 0.0; // not enough data
-
-                double W = static_cast<double>(m_nWins) / total;
-                double avgWin = m_dWinSum / m_nWins;
-                double avgLoss = m_dLossSum / m_nLosses;
-                double R = avgWin / avgLoss;
-
-                return W - ((1.0 - W) / R);
+                return kellyFraction(m_nWins, m_dWinSum, m_nLosses, m_dLossSum);
             }
 
         private:
@@ -0,0 +1,153 @@
+#ifndef PORTFOLIOKELLY_H_
+#define PORTFOLIOKELLY_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+#include <xtensor/containers/xtensor.hpp>
+
+#include "../models/linear/solvers.hpp"
+
+namespace sizing {
+
+    // Kelly fractions f = Sigma^{-1} mu across several return streams
+    //
+    // The mean and the sum of squared deviations M are updated per return vector
+    // with Welford's recurrence, which adds the rank one term (k - 1) / k d d^{t} to M.
+    // The Cholesky factor of M + w v I is updated alongside, so a rebalance is two
+    // triangular solves, O(n^2), instead of a fresh O(n^3) inversion. The covariance
+    // used is
+    //
+    //     Sigma = (M + w v I) / (k - 1 + w)
+    //
+    // i.e. the sample covariance shrunk towards v I, the prior carrying the weight
+    // of w observations so its influence fades as returns accumulate. The fractions
+    // are scaled by the fractional Kelly multiplier and, when their gross leverage
+    // sum |f_i| exceeds the cap, scaled down to it.
+    class PortfolioKelly {
+
+        public:
+
+            PortfolioKelly(std::size_t nAssets, double priorVariance, double priorWeight = 1.0,
+                           double fraction = 1.0, double maxLeverage = std::numeric_limits<double>::infinity())
+                : m_n(nAssets), m_priorWeight(priorWeight), m_fraction(fraction), m_maxLeverage(maxLeverage) {
+                /*
+                 * nAssets : number of return streams, strategies or spreads
+                 *
+                 * priorVariance : v, per asset variance of the shrinkage target v I
+                 *
+                 * priorWeight : w, number of observations the target is worth
+                 *
+                 * fraction : fractional Kelly multiplier, e.g. 0.5 for half Kelly
+                 *
+                 * maxLeverage : cap on sum |f_i|
+                 */
+
+                if (nAssets == 0)
+                    throw std::invalid_argument("sizing::PortfolioKelly : At least one asset is required.");
+                if (!(priorVariance > 0.0) || !(priorWeight > 0.0))
+                    throw std::invalid_argument("sizing::PortfolioKelly : Prior variance and weight must be positive.");
+                if (!(fraction > 0.0) || !(maxLeverage > 0.0))
+                    throw std::invalid_argument("sizing::PortfolioKelly : Fraction and leverage cap must be positive.");
+
+                m_mean.assign(m_n, 0.0);
+                m_L.assign(m_n * m_n, 0.0);
+                m_x.resize(m_n);
+
+                const double d = std::sqrt(priorWeight * priorVariance);
+                for (std::size_t i = 0; i < m_n; ++i)
+                    m_L[i * m_n + i] = d;
+            }
+
+            // Adds one observation, r holds a return per asset
+            void update(const double* r) {
+                ++m_count;
+                const double k = static_cast<double>(m_count);
+                const double scale = std::sqrt((k - 1.0) / k);
+
+                for (std::size_t i = 0; i < m_n; ++i) {
+                    const double d = r[i] - m_mean[i];
+                    m_mean[i] += d / k;
+                    m_x[i] = scale * d;
+                }
+
+                if (m_count > 1)
+                    linModels::solvers::cholUpdate(m_L.data(), m_n, m_x.data());
+            }
+
+            void update(const xt::xtensor<double, 1>& r) {
+                if (r.size() != m_n)
+                    throw std::invalid_argument("sizing::PortfolioKelly::update : Expected one return per asset.");
+                update(r.data());
+            }
+
+            // Writes the capped fractional Kelly weights into out (nAssets), zeros until two observations
+            void getKelly(double* out) const {
+                if (m_count < 2) {
+                    std::fill(out, out + m_n, 0.0);
+                    return;
+                }
+
+                // Sigma^{-1} mu = (k - 1 + w) (L L^{t})^{-1} mu
+                std::copy(m_mean.begin(), m_mean.end(), out);
+                linModels::solvers::forwardSubst(m_L.data(), m_n, out);
+                linModels::solvers::backSubstT(m_L.data(), m_n, out);
+
+                double scale = m_fraction * (static_cast<double>(m_count) - 1.0 + m_priorWeight);
+                double gross = 0.0;
+                for (std::size_t i = 0; i < m_n; ++i)
+                    gross += std::abs(out[i]);
+                gross *= scale;
+                if (gross > m_maxLeverage)
+                    scale *= m_maxLeverage / gross;
+
+                for (std::size_t i = 0; i < m_n; ++i)
+                    out[i] *= scale;
+            }
+
+            xt::xtensor<double, 1> getKelly() const {
+                xt::xtensor<double, 1> f = xt::empty<double>({m_n});
+                getKelly(f.data());
+                return f;
+            }
+
+            // Shrunk covariance Sigma rebuilt from the factor, O(n^3), for inspection
+            xt::xtensor<double, 2> covariance() const {
+                const double denom = static_cast<double>(m_count) - 1.0 + m_priorWeight;
+                xt::xtensor<double, 2> S = xt::empty<double>({m_n, m_n});
+                for (std::size_t i = 0; i < m_n; ++i) {
+                    for (std::size_t j = 0; j <= i; ++j) {
+                        double s = 0.0;
+                        for (std::size_t p = 0; p <= j; ++p)
+                            s += m_L[i * m_n + p] * m_L[j * m_n + p];
+                        S(i, j) = s / denom;
+                        S(j, i) = S(i, j);
+                    }
+                }
+                return S;
+            }
+
+            const std::vector<double>& mean() const {return m_mean;}
+
+            std::size_t count() const {return m_count;}
+
+            std::size_t assets() const {return m_n;}
+
+        private:
+
+            std::size_t m_n;
+            double m_priorWeight;
+            double m_fraction;
+            double m_maxLeverage;
+
+            std::size_t m_count = 0;
+            std::vector<double> m_mean;
+            std::vector<double> m_L; // row major lower Cholesky factor of M + w v I
+            std::vector<double> m_x; // update vector
+    };
+}
+
+#endif // PORTFOLIOKELLY_H_
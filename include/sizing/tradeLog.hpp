@@ -0,0 +1,130 @@
+#ifndef TRADELOG_H_
+#define TRADELOG_H_
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+
+namespace sizing {
+
+    enum class slotState {READY, PENDING, OVERWRITTEN};
+
+    // Fixed capacity log of trade results shared between recording and sizing threads
+    //
+    // Every push takes a ticket from a single atomic counter and publishes the value
+    // into slot ticket % capacity under a per slot sequence word, so recording is
+    // wait free and never blocks. Readers check the sequence word around the value
+    // to tell a published trade from one that is still being written or that a later
+    // ticket has already overwritten.
+    //
+    // Writers a multiple of capacity tickets apart can meet in a slot when one is
+    // preempted for a full lap. The sequence word only ever moves forward and a
+    // writer claims the slot only while no other writer is in it, so the value is
+    // never written by two writers at once and an older trade never replaces a newer
+    // one. A writer that finds a newer ticket already in the slot drops its trade,
+    // and one that finds an older writer still in flight marks its own trade as lost
+    // instead of waiting. Dropped and lost trades read as OVERWRITTEN, never as
+    // PENDING, so readers do not stall on them.
+    class TradeLog {
+
+        public:
+
+            explicit TradeLog(std::size_t capacity) : m_capacity(capacity) {
+                if (capacity == 0)
+                    throw std::invalid_argument("sizing::TradeLog : Capacity must be positive.");
+                m_slots = std::make_unique<Slot[]>(capacity);
+            }
+
+            TradeLog(const TradeLog&) = delete;
+            TradeLog& operator=(const TradeLog&) = delete;
+
+            // Records value and returns its ticket
+            std::uint64_t push(double value) {
+                const std::uint64_t ticket = m_end.fetch_add(1, std::memory_order_relaxed);
+                Slot& s = m_slots[ticket % m_capacity];
+                const std::uint64_t claimed = word(ticket, IN_FLIGHT);
+
+                std::uint64_t cur = s.seq.load(std::memory_order_acquire);
+                for (;;) {
+                    if (ticketOf(cur) >= ticket + 1)
+                        return ticket; // lapped while preempted, the stale trade is dropped
+
+                    const std::uint64_t st = cur & stateMask;
+                    const bool busy = (st == IN_FLIGHT || st == LOST_BUSY);
+                    const std::uint64_t next = busy ? word(ticket, LOST_BUSY) : claimed;
+                    if (s.seq.compare_exchange_weak(cur, next, std::memory_order_acq_rel, std::memory_order_acquire)) {
+                        if (busy)
+                            return ticket; // an older writer is mid write, ours is recorded as lost
+                        break;
+                    }
+                }
+
+                std::atomic_thread_fence(std::memory_order_release);
+                s.value.store(value, std::memory_order_relaxed);
+
+                // newer writers may only have marked themselves lost meanwhile, in which
+                // case the slot is handed over idle with their mark instead of our trade
+                cur = claimed;
+                while (!s.seq.compare_exchange_weak(cur, cur == claimed ? word(ticket, PUBLISHED) : (cur & ~stateMask) | LOST_IDLE,
+                                                    std::memory_order_release, std::memory_order_relaxed)) {}
+
+                return ticket;
+            }
+
+            // Reads the value of ticket if it is published and not yet overwritten
+            slotState read(std::uint64_t ticket, double& value) const {
+                const Slot& s = m_slots[ticket % m_capacity];
+
+                const std::uint64_t before = s.seq.load(std::memory_order_acquire);
+                const std::uint64_t owner = ticketOf(before);
+                if (owner < ticket + 1)
+                    return slotState::PENDING;
+                if (owner > ticket + 1)
+                    return slotState::OVERWRITTEN;
+                if ((before & stateMask) == IN_FLIGHT)
+                    return slotState::PENDING;
+                if ((before & stateMask) != PUBLISHED)
+                    return slotState::OVERWRITTEN; // lost to a writer that was still in the slot
+
+                value = s.value.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+
+                return s.seq.load(std::memory_order_relaxed) == before ? slotState::READY : slotState::OVERWRITTEN;
+            }
+
+            // Number of tickets issued, i.e. one past the newest ticket
+            std::uint64_t end() const {return m_end.load(std::memory_order_acquire);}
+
+            std::size_t capacity() const {return m_capacity;}
+
+        private:
+
+            // Sequence word (ticket + 1) * 4 + state, 0 is an empty slot. Ordering by the
+            // word orders by ticket, so it only ever moves forward.
+            static constexpr std::uint64_t PUBLISHED = 0; // value of the ticket is readable
+            static constexpr std::uint64_t IN_FLIGHT = 1; // ticket's writer owns the slot
+            static constexpr std::uint64_t LOST_BUSY = 2; // ticket lost, an older writer still owns the slot
+            static constexpr std::uint64_t LOST_IDLE = 3; // ticket lost, slot free
+            static constexpr std::uint64_t stateMask = 3;
+
+            static std::uint64_t word(std::uint64_t ticket, std::uint64_t state) {return ((ticket + 1) << 2) | state;}
+            static std::uint64_t ticketOf(std::uint64_t w) {return w >> 2;} // ticket + 1
+
+            // one cache line per slot, writers with consecutive tickets would otherwise
+            // share a line and bounce it between cores on every push
+            struct alignas(64) Slot {
+                std::atomic<std::uint64_t> seq{0};
+                std::atomic<double> value{0.0};
+            };
+
+            std::size_t m_capacity;
+            std::unique_ptr<Slot[]> m_slots;
+
+            // own cache line, it is the one location every writer touches
+            alignas(64) std::atomic<std::uint64_t> m_end{0};
+    };
+}
+
+#endif // TRADELOG_H_
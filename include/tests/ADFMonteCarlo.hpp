@@ -0,0 +1,368 @@
+#ifndef ADFMONTECARLO_H_
+#define ADFMONTECARLO_H_
+
+/**
+ * Monte Carlo null distribution of the ADF statistic
+ *
+ * The MacKinnon surfaces are response surface fits that are poor for short
+ * samples. Here the statistic is simulated under the unit root null
+ * y_t = y_{t-1} + e_t, e_t ~ N(0, 1), y_0 = 0, for the exact series length,
+ * deterministic terms and lag of the test, and the p-value is read from the
+ * simulated quantiles.
+ *
+ * Replications run in blocks, each block drawing from its own generator seeded
+ * by (seed, block), so a table depends only on the configuration and not on the
+ * number of threads. Normals come from an explicit Box-Muller transform over the
+ * raw bits of std::mt19937_64, whose output the standard fixes, rather than
+ * std::normal_distribution, whose algorithm differs between standard libraries,
+ * so cached tables are portable. Tables are cached in memory for the lifetime of the process
+ * and, when a cache directory is set, on disk, so each configuration is
+ * simulated once.
+ */
+
+#include "ADFT.hpp"
+#include "../tools/parallel.hpp"
+#include "../tools/trend.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+namespace tests {
+
+    namespace adf {
+
+        struct MonteCarloConfig {
+            std::size_t reps = 100000; // simulated statistics
+            std::uint64_t seed = 12345;
+            std::size_t nThreads = 0; // 0 uses the hardware concurrency
+            // directory for cached tables, empty falls back to the TSA_ADF_CACHE_DIR
+            // environment variable, memory only caching when neither is set
+            std::string cacheDir = "";
+        };
+
+        // Simulated quantiles of the ADF statistic for one (nobs, regression, lag)
+        class NullDistribution {
+
+            public:
+
+                // Probabilities of the stored quantiles are i / (quantiles - 1)
+                static constexpr std::size_t nQuantiles = 2001;
+
+                NullDistribution(std::size_t nobs, tools::trendType trend, int lag, std::size_t reps,
+                                 std::vector<double> quantiles)
+                    : m_nobs(nobs), m_trend(trend), m_lag(lag), m_reps(reps), m_q(std::move(quantiles)) {
+                    if (m_q.size() != nQuantiles)
+                        throw std::invalid_argument("tests::adf::NullDistribution : Unexpected quantile count.");
+                }
+
+                // Builds the table from simulated statistics, sorts stats in place
+                static std::vector<double> quantilesOf(std::vector<double>& stats) {
+                    std::sort(stats.begin(), stats.end());
+                    std::vector<double> q(nQuantiles);
+                    const double last = static_cast<double>(stats.size() - 1);
+                    for (std::size_t i = 0; i < nQuantiles; ++i) {
+                        double pos = last * static_cast<double>(i) / static_cast<double>(nQuantiles - 1);
+                        std::size_t lo = static_cast<std::size_t>(pos);
+                        std::size_t hi = std::min(lo + 1, stats.size() - 1);
+                        q[i] = stats[lo] + (pos - static_cast<double>(lo)) * (stats[hi] - stats[lo]);
+                    }
+                    return q;
+                }
+
+                // Probability of a statistic at or below stat under the null
+                double pValue(double stat) const {
+                    if (stat <= m_q.front())
+                        return 0.0;
+                    if (stat >= m_q.back())
+                        return 1.0;
+                    std::size_t hi = static_cast<std::size_t>(std::upper_bound(m_q.begin(), m_q.end(), stat) - m_q.begin());
+                    std::size_t lo = hi - 1;
+                    double w = (m_q[hi] > m_q[lo]) ? (stat - m_q[lo]) / (m_q[hi] - m_q[lo]) : 0.0;
+                    return (static_cast<double>(lo) + w) / static_cast<double>(nQuantiles - 1);
+                }
+
+                // Statistic with probability level below it, e.g. 0.05 for the 5% critical value
+                double critValue(double level) const {
+                    if (!(level >= 0.0 && level <= 1.0))
+                        throw std::invalid_argument("tests::adf::NullDistribution::critValue : Level must be in [0, 1].");
+                    double pos = level * static_cast<double>(nQuantiles - 1);
+                    std::size_t lo = std::min(static_cast<std::size_t>(pos), nQuantiles - 2);
+                    return m_q[lo] + (pos - static_cast<double>(lo)) * (m_q[lo + 1] - m_q[lo]);
+                }
+
+                // 1%, 5% and 10% critical values, ordered as mackinnon::crit_value
+                std::array<double, 3> critValues() const {
+                    return {critValue(0.01), critValue(0.05), critValue(0.10)};
+                }
+
+                std::size_t nobs() const {return m_nobs;}
+                tools::trendType trend() const {return m_trend;}
+                int lag() const {return m_lag;}
+                std::size_t reps() const {return m_reps;}
+                const std::vector<double>& quantiles() const {return m_q;}
+
+            private:
+
+                std::size_t m_nobs;
+                tools::trendType m_trend;
+                int m_lag;
+                std::size_t m_reps;
+                std::vector<double> m_q;
+        };
+
+        namespace detail {
+
+            // replications per generator stream
+            constexpr std::size_t mcBlock = 256;
+
+            // Generator and normal transform, recorded with cached tables
+            inline constexpr const char* mcGenerator = "mt64bm";
+
+            // Uniform on (0, 1] from the top 53 bits, never 0 so the log is finite
+            inline double unitUniform(std::uint64_t bits) {
+                return (static_cast<double>(bits >> 11) + 1.0) * 0x1.0p-53;
+            }
+
+            // Fills out with n N(0, 1) draws
+            //
+            // The engine is drawn first and the Box-Muller transform then runs as one
+            // branch free pass over the block, which the compiler can vectorize, instead
+            // of interleaving engine calls with the transcendental functions.
+            inline void fillNormal(std::mt19937_64& gen, double* out, std::size_t n) {
+                constexpr double twoPi = 6.283185307179586476925286766559;
+                const std::size_t pairs = n / 2;
+                for (std::size_t i = 0; i < 2 * pairs; ++i)
+                    out[i] = unitUniform(gen());
+                for (std::size_t i = 0; i < pairs; ++i) {
+                    const double r = std::sqrt(-2.0 * std::log(out[2 * i]));
+                    const double theta = twoPi * out[2 * i + 1];
+                    out[2 * i] = r * std::cos(theta);
+                    out[2 * i + 1] = r * std::sin(theta);
+                }
+                if (n % 2 != 0) {
+                    const double u1 = unitUniform(gen());
+                    const double u2 = unitUniform(gen());
+                    out[n - 1] = std::sqrt(-2.0 * std::log(u1)) * std::cos(twoPi * u2);
+                }
+            }
+
+            // Simulates reps ADF statistics under the null into stats
+            template <tools::trendType TT>
+            inline void simulateNull(std::size_t nobs, int lag, std::size_t reps, std::uint64_t seed,
+                                     std::size_t nThreads, std::vector<double>& stats) {
+                stats.resize(reps);
+                const std::size_t nBlocks = (reps + mcBlock - 1) / mcBlock;
+                std::vector<ADFWorkspace> ws(tools::workerCount(nBlocks, nThreads));
+
+                tools::parallelFor(nBlocks, nThreads, [&](std::size_t b, std::size_t w) {
+                    ADFWorkspace& scratch = ws[w];
+                    if (scratch.x.size() != nobs) {
+                        scratch.x.resize({nobs});
+                        scratch.xdiff.resize({nobs - 1});
+                    }
+
+                    std::seed_seq seq{static_cast<std::uint32_t>(seed), static_cast<std::uint32_t>(seed >> 32),
+                                      static_cast<std::uint32_t>(b), static_cast<std::uint32_t>(b >> 32)};
+                    std::mt19937_64 gen(seq);
+
+                    const std::size_t first = b * mcBlock;
+                    const std::size_t last = std::min(reps, first + mcBlock);
+                    double* x = scratch.x.data();
+                    double* e = scratch.xdiff.data();
+                    for (std::size_t r = first; r < last; ++r) {
+                        // the innovations are the differences, the walk is their running sum
+                        fillNormal(gen, e, nobs - 1);
+                        x[0] = 0.0;
+                        for (std::size_t t = 1; t < nobs; ++t)
+                            x[t] = x[t - 1] + e[t - 1];
+
+                        fitLag<TT>(x, scratch, lag);
+                        stats[r] = scratch.res.tValues[0];
+                    }
+                });
+            }
+
+            inline std::filesystem::path cacheDirOf(const MonteCarloConfig& cfg) {
+                if (!cfg.cacheDir.empty())
+                    return cfg.cacheDir;
+                if (const char* env = std::getenv("TSA_ADF_CACHE_DIR"))
+                    return env;
+                return {};
+            }
+
+            inline std::filesystem::path cacheFile(const std::filesystem::path& dir, std::size_t nobs,
+                                                   tools::trendType trend, int lag, const MonteCarloConfig& cfg) {
+                return dir / ("adf_null_n" + std::to_string(nobs) + "_" + tools::trendName(trend) + "_l" + std::to_string(lag)
+                              + "_r" + std::to_string(cfg.reps) + "_s" + std::to_string(cfg.seed) + "_" + mcGenerator + ".txt");
+            }
+
+            // Loads a cached table, nullptr when missing or unreadable
+            inline std::shared_ptr<const NullDistribution> loadNull(const std::filesystem::path& file, std::size_t nobs,
+                                                                    tools::trendType trend, int lag, std::size_t reps) {
+                std::ifstream in(file);
+                if (!in)
+                    return nullptr;
+
+                std::string magic, generator;
+                std::size_t n = 0, r = 0, nq = 0;
+                int l = -1;
+                if (!(in >> magic >> generator >> n >> l >> r >> nq) || magic != "tsa-adf-null-2" || generator != mcGenerator
+                    || n != nobs || l != lag || r != reps || nq != NullDistribution::nQuantiles)
+                    return nullptr;
+
+                std::vector<double> q(nq);
+                for (double& v : q) {
+                    if (!(in >> v))
+                        return nullptr;
+                }
+                return std::make_shared<const NullDistribution>(nobs, trend, lag, reps, std::move(q));
+            }
+
+            // Writes through a temporary file so readers never see a partial table
+            inline void storeNull(const std::filesystem::path& file, const NullDistribution& dist) {
+                std::error_code ec;
+                std::filesystem::create_directories(file.parent_path(), ec);
+
+                std::filesystem::path tmp = file;
+                tmp += ".tmp" + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id()));
+                {
+                    std::ofstream out(tmp);
+                    if (!out)
+                        return; // the disk cache is best effort
+                    out.precision(17);
+                    out << "tsa-adf-null-2 " << mcGenerator << ' ' << dist.nobs() << ' ' << dist.lag() << ' ' << dist.reps() << ' '
+                        << dist.quantiles().size() << '\n';
+                    for (double v : dist.quantiles())
+                        out << v << '\n';
+                    if (!out)
+                        return;
+                }
+                std::filesystem::rename(tmp, file, ec);
+                if (ec)
+                    std::filesystem::remove(tmp, ec);
+            }
+
+            using NullKey = std::tuple<std::size_t, tools::trendType, int, std::size_t, std::uint64_t>;
+            using NullFuture = std::shared_future<std::shared_ptr<const NullDistribution>>;
+
+            inline std::mutex& nullCacheMutex() {
+                static std::mutex m;
+                return m;
+            }
+
+            inline std::map<NullKey, NullFuture>& nullCache() {
+                static std::map<NullKey, NullFuture> cache;
+                return cache;
+            }
+        }
+
+        // Null distribution for series of nobs observations, simulated on first use
+        //
+        // Concurrent requests for the same configuration wait for a single simulation.
+        inline std::shared_ptr<const NullDistribution> nullDistribution(std::size_t nobs, tools::trendType trend, int lag,
+                                                                        const MonteCarloConfig& cfg = {}) {
+            constexpr std::size_t minReps = 100;
+            if (lag < 0)
+                throw std::invalid_argument("tests::adf::nullDistribution : Lag must be non-negative.");
+            if (cfg.reps < minReps)
+                throw std::invalid_argument("tests::adf::nullDistribution : At least 100 replications are required.");
+            const std::size_t k = 1 + static_cast<std::size_t>(lag) + tools::ntrendOf(trend);
+            if (nobs < 2 + static_cast<std::size_t>(lag) + k)
+                throw std::invalid_argument("tests::adf::nullDistribution : Series is too short for the lag and regression.");
+
+            const detail::NullKey key{nobs, trend, lag, cfg.reps, cfg.seed};
+
+            std::promise<std::shared_ptr<const NullDistribution>> promise;
+            detail::NullFuture pending;
+            {
+                std::lock_guard<std::mutex> lock(detail::nullCacheMutex());
+                auto& cache = detail::nullCache();
+                auto it = cache.find(key);
+                if (it != cache.end())
+                    pending = it->second;
+                else
+                    cache.emplace(key, promise.get_future().share());
+            }
+            if (pending.valid())
+                return pending.get(); // simulated or being simulated by another caller
+
+            try {
+                const std::filesystem::path dir = detail::cacheDirOf(cfg);
+                std::filesystem::path file;
+                std::shared_ptr<const NullDistribution> dist;
+                if (!dir.empty()) {
+                    file = detail::cacheFile(dir, nobs, trend, lag, cfg);
+                    dist = detail::loadNull(file, nobs, trend, lag, cfg.reps);
+                }
+
+                if (!dist) {
+                    std::vector<double> stats;
+                    tools::withTrend(trend, [&](auto t) {
+                        detail::simulateNull<decltype(t)::value>(nobs, lag, cfg.reps, cfg.seed, cfg.nThreads, stats);
+                    });
+                    dist = std::make_shared<const NullDistribution>(nobs, trend, lag, cfg.reps,
+                                                                    NullDistribution::quantilesOf(stats));
+                    if (!file.empty())
+                        detail::storeNull(file, *dist);
+                }
+
+                promise.set_value(dist);
+                return dist;
+            } catch (...) {
+                promise.set_exception(std::current_exception());
+                std::lock_guard<std::mutex> lock(detail::nullCacheMutex());
+                detail::nullCache().erase(key);
+                throw;
+            }
+        }
+
+        inline std::shared_ptr<const NullDistribution> nullDistribution(std::size_t nobs, const std::string& regression, int lag,
+                                                                        const MonteCarloConfig& cfg = {}) {
+            return nullDistribution(nobs, tools::parseTrend(regression), lag, cfg);
+        }
+
+        // adfuller with the p-value and critical values read from the simulated null
+        //
+        // The null is simulated for the length of x and the lag adfuller ends up using,
+        // so with autolag the p-value is conditional on the selected lag.
+        inline ADFResult adfullerMC(const xt::xtensor<double, 1>& x, ADFWorkspace& ws, int maxlag = 0,
+                                    std::string regression = "c", std::string autolag = "AIC",
+                                    const MonteCarloConfig& cfg = {}) {
+            ADFResult res = adfuller(x, ws, maxlag, regression, autolag);
+
+            std::shared_ptr<const NullDistribution> dist = nullDistribution(x.size(), tools::parseTrend(regression),
+                                                                            res.usedlag, cfg);
+            res.pvalue = dist->pValue(res.adfstat);
+
+            res.critvalues = dist->critValues();
+
+            return res;
+        }
+
+        inline ADFResult adfullerMC(xt::xtensor<double, 1> x, int maxlag = 0, std::string regression = "c",
+                                    std::string autolag = "AIC", const MonteCarloConfig& cfg = {}) {
+            ADFWorkspace ws;
+            return adfullerMC(x, ws, maxlag, regression, autolag, cfg);
+        }
+    }
+}
+
+#endif // ADFMONTECARLO_H_
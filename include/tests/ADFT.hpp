@@ -18,10 +18,21 @@
 
 #include "../models/linear/RegressionModel.hpp"
 #include "../tools/coreTools.hpp"
+#include "../tools/lagMatrix.hpp"
 #include "../models/linear/modelHelpers.hpp"
+#include "../models/linear/OLSEstimator.hpp"
 #include "../tools/MacKinnonValues.hpp"
+#include "../tools/instrumentation.hpp"
+#include "../tools/parallel.hpp"
+#include "../tools/trend.hpp"
+#include <algorithm>
+#include <array>
 #include <cmath>
+#include <limits>
+#include <map>
 #include <stdexcept>
+#include <string>
+#include <vector>
 
 #include <xtensor/containers/xadapt.hpp>
 
@@ -34,67 +45,109 @@ namespace tests {
             double pvalue;
             int usedlag;
             std::size_t nobs;
-            std::map<std::string, double> critvalues;
+            std::array<double, 3> critvalues; // 1%, 5% and 10%, inline so results own no heap memory
             double icbest;
+
+            // Critical values keyed "1%", "5%" and "10%" as statsmodels reports them
+            std::map<std::string, double> critvaluesMap() const {
+                return {{"1%", critvalues[0]}, {"5%", critvalues[1]}, {"10%", critvalues[2]}};
+            }
         };
 
-        inline ADFResult adfuller(xt::xtensor<double, 1> x, int maxlag = 0, std::string regression = "c",
-                      std::string autolag = "AIC", bool store = false, bool regresults = false) {
+        // Scratch reused across adfuller calls, one per thread
+        template <typename T>
+        struct BasicADFWorkspace {
+            xt::xtensor<T, 1> x; // series buffer for batch rows
+            xt::xtensor<T, 1> xdiff; // first differences of the series
+            linModels::BasicNestedOLS<T> nested; // autolag factorization
+            linModels::BasicOLSEstimator<T> ols; // final regression
+            linModels::BasicRegressionResult<T> res;
+            std::vector<T> gamma; // residual autocovariances for the Phillips-Perron correction
+            std::vector<T> centred; // demeaned residuals for the Phillips-Perron correction without a constant
+        };
+
+        using ADFWorkspace = BasicADFWorkspace<double>;
+
+        namespace detail {
+
+            // Lag criterion named by an autolag string, any value other than AIC, BIC
+            // or t-stat has always meant no lag selection
+            inline tools::lagCriterion parseAutolag(const std::string& autolag) {
+                try {
+                    return tools::parseCriterion(autolag);
+                } catch (const std::invalid_argument&) {
+                    return tools::lagCriterion::NONE;
+                }
+            }
+
+            // First differences of x into ws.xdiff, reusing its storage
+            template <typename T>
+            inline void difference(const xt::xtensor<T, 1>& x, BasicADFWorkspace<T>& ws) {
+                const std::size_t xlen = x.shape(0);
+                if (ws.xdiff.size() != xlen - 1)
+                    ws.xdiff.resize({xlen - 1});
+                for (std::size_t i = 0; i + 1 < xlen; ++i)
+                    ws.xdiff(i) = x(i + 1) - x(i);
+            }
+
+            // Fits the ADF regression with lag lagged differences into ws.res
+            //
+            // ws.xdiff must hold the differences of the series x, the levels x_{t-1}
+            // are read from x. The level coefficient comes first.
+            template <tools::trendType TT, typename T>
+            inline void fitLag(const T* x, BasicADFWorkspace<T>& ws, int lag) {
+                constexpr int ntrend = static_cast<int>(tools::trendTraits<TT>::ntrend);
+                const T* xd = ws.xdiff.data();
+                const std::size_t nd = ws.xdiff.size();
+                const std::size_t nobs = nd - static_cast<std::size_t>(lag);
+
+                tools::BasicLagMatrix<T> rhs(xd, nd, lag, lag + 1, ntrend, false, x + lag);
+                tools::BasicVectorView<T> xdshort(xd + lag, nobs);
+                ws.ols.fit(rhs, xdshort, ws.res);
+            }
+        }
+
+        // ADF test specialized on the deterministic terms and the lag criterion, the
+        // trend width and the selection rule are resolved at compile time. The regression
+        // runs in the scalar type T of the series, the reported statistics are double.
+        template <tools::trendType TT, tools::lagCriterion LC, typename T>
+        inline ADFResult adfuller(const xt::xtensor<T, 1>& x, BasicADFWorkspace<T>& ws, int maxlag = 0) {
             /**
              * x : 1d array of test data
              *
              * maxLag : int, Maximum lag which is included in the test
              *          default value of 12*(nobs/100)^{1/4} is used when 0.
              *
-             * regression : {"c", "ct", "ctt", "n"}
-             *          constant and trend order to include in regression
+             * TT : tools::trendType, constant and trend order to include in regression
              *
-             *          * "c" : constant only
-             *          * "ct" : constant and trend
-             *          * "ctt" : constant, linear, and quadratic trend
-             *          * "n" : no constant, no trend
+             *          * C : constant only
+             *          * CT : constant and trend
+             *          * CTT : constant, linear, and quadratic trend
+             *          * N : no constant, no trend
              *
-             * autolag : {"AIC", "BIC", "t-stat", ""}
-             *          Method to use when automatically determining the lag length among the
-             *          values 0, 1, ..., maxlag.
+             * LC : tools::lagCriterion, method to use when automatically determining
+             *          the lag length among the values 0, 1, ..., maxlag.
              *
-             *          * If "AIC" (default) or "BIC", then the number of lags is chosen
+             *          * If AIC or BIC, then the number of lags is chosen
              *            to minimize the corresponding information criterion.
-             *          * "t-stat" based choice of maxlag.  Starts with maxlag and drops a
+             *          * TSTAT based choice of maxlag.  Starts with maxlag and drops a
              *            lag until the t-statistic on the last lag length is significant
              *            using a 5%-sized test.
-             *          * If None, then the number of included lags is set to maxlag.
-             * store : bool
-             *         If true then a result instance is returned as well as the ADF stats
-             * regresults : bool
-             *         If true then return the full regression results
+             *          * If NONE, then the number of included lags is set to maxlag.
              */
 
-            // initial lines ensure type correctness in python function
-            // will ignore for now are correctness is ensured by type definition for params
-
             // check that data is none constant
-            if (xt::amax(x) == xt::amin(x)) {
+            auto range = std::minmax_element(x.begin(), x.end());
+            if (range.first == x.end() || *range.first == *range.second) {
                 throw std::invalid_argument("Invalid input, x is constant");
             }
 
-            // store regression results so store must be true
-            if (regresults)
-                store = true;
-
             // nobs is a return value regarding the number of observations
             // used for the ADF regression and calculation of the critical values.
             std::size_t nobs = x.shape()[0];
 
-            // ntrend seems to be used in the maxlag calc if
-            // maxlag is calculated rather than inputted and it is smaller than
-            // using ntrend
-            int ntrend;
-            if (regression == "n") ntrend = 0;
-            else if (regression == "c") ntrend = 1;
-            else if (regression == "ct") ntrend = 2;
-            else if (regression == "ctt") ntrend = 3;
-            else throw std::invalid_argument("Invalid regression type");
+            // ntrend is used in the maxlag calc if maxlag is calculated rather than inputted
+            constexpr int ntrend = static_cast<int>(tools::trendTraits<TT>::ntrend);
 
             if (maxlag == 0) {
                 // from Greene referencing Schwert 1989
@@ -103,113 +156,197 @@ namespace tests {
                 // may need floor for first arg
                 maxlag = std::min(static_cast<int>(nobs) / 2 - ntrend - 1, maxlag);
                 if (maxlag < 0) {
-                    throw std::runtime_error("Sample size is to short to use the selected regression component");
+                    throw std::invalid_argument("Sample size is to short to use the selected regression component");
                 }
             }else if (maxlag > nobs / 2 - ntrend - 1) {
-                std::cout << "maxlag must be less than (nobs / 2 - 1 - ntrend) where ntrend is the number of" <<
-                    " included deterministic regressors." << std::endl;
+                TSA_WARN("maxlag must be less than (nobs / 2 - 1 - ntrend) where ntrend is the number of"
+                         " included deterministic regressors.");
             }
 
-            //std::cout << "Checking maxlag : " << maxlag << std::endl;
+            // get the discrete difference along the given axis, kept in the workspace
+            const std::size_t xlen = x.shape(0);
+            {
+                TSA_STAGE(DIFF);
+                detail::difference(x, ws);
+            }
 
-            // get the discrete difference along the given axis
-            xt::xtensor<double, 1> xdiff = xt::diff(x);
-            //std::cout << "Checking xdiff : " << xt::adapt(xdiff.shape()) << std::endl;
-            //std::cout << xdiff << std::endl;
+            if (static_cast<std::size_t>(maxlag) >= ws.xdiff.size())
+                throw std::invalid_argument("tests::adf::adfuller : maxlag must be < nobs");
 
-            xt::xtensor<double, 2> xdall = tools::lagmat(xdiff, maxlag, "both", "in");
-            //std::cout << "Checking xdall : " << xt::adapt(xdall.shape()) << std::endl;
-            //std::cout << xdall << std::endl;
+            // The design matrices below are lazy views over xdiff and x, equivalent to
+            // lagmat(xdiff, lag, "both", "in") with column 0 replaced by the levels
+            // x_{t-1} and addTrend applied, but nothing is materialized.
+            const T* xd = ws.xdiff.data();
+            const std::size_t nd = ws.xdiff.size();
 
-            nobs = xdall.shape()[0];
+            nobs = nd - maxlag;
 
-            xt::view(xdall, xt::all(), 0) = xt::view(x, xt::range(x.shape()[0] - nobs - 1, x.shape()[0] - 1));
-            //std::cout << "Checking xdall v2 : " << xt::adapt(xdall.shape()) << std::endl;
-            //std::cout << xdall << std::endl;
+            int usedlag = maxlag;
+            double icbest = -1.0;
+            if constexpr (LC != tools::lagCriterion::NONE) {
+                TSA_STAGE(AUTOLAG);
 
-            xt::xtensor<double, 1> xdshort = xt::view(xdiff, xt::range(-nobs, xt::all()));
-            //std::cout << "Checking xdshort : " << xt::adapt(xdshort.shape()) << std::endl;
-            //std::cout << xdshort << std::endl;
+                // trend columns first so lag orders are nested column prefixes
+                tools::BasicLagMatrix<T> fullRHS(xd, nd, maxlag, maxlag + 1, ntrend, true, x.data() + (xlen - nobs - 1));
+                tools::BasicVectorView<T> xdshort(xd + maxlag, nobs);
 
-            xt::xtensor<double, 2> fullRHS;
-            int usedlag;
-            double icbest;
-            if (autolag == "AIC" || autolag == "BIC" || autolag == "t-stat") {
+                constexpr int startLag = ntrend + 1;
 
-                if (regression == "c" || regression == "ct" || regression == "ctt") {
-                    fullRHS = tools::addTrend(xdall, regression, true);
-                }else {
-                    fullRHS = xdall;
-                }
+                tools::autoLagResult autoRes = tools::autoLag<LC>(linModels::OLS, fullRHS, xdshort,
+                                                                  startLag, maxlag, ws.nested);
 
-                //std::cout << "Checking fullRHS : " << xt::adapt(fullRHS.shape()) << std::endl;
-                //std::cout << fullRHS << std::endl;
+                icbest = autoRes.icbest;
+                int bestlag = autoRes.bestLag;
 
-                int startLag = fullRHS.shape(1) - xdall.shape(1) + 1;
+                bestlag -= startLag;
 
-                //std::cout << "Checking startLag : " << startLag << std::endl;
+                // rerun OLS with best autolag, which uses more observations
+                nobs = nd - bestlag;
 
-                tools::autoLagResult autoRes = tools::autoLag(linModels::OLS, fullRHS, xdshort,
-                                                              startLag, maxlag, autolag);
+                usedlag = bestlag;
+            }
 
-                //std::cout << "Checking autolag results ..." << std::endl;
-                //std::cout << "icbest : " << autoRes.icbest << std::endl;
-                //std::cout << "bestlag : " << autoRes.bestLag << std::endl;
+            linModels::BasicRegressionResult<T>& resols = ws.res;
+            {
+                TSA_STAGE(FIT);
+                detail::fitLag<TT>(x.data(), ws, usedlag);
+            }
 
-                icbest = autoRes.icbest;
-                int bestlag = autoRes.bestLag;
+            double adfstat = static_cast<double>(resols.tValues[0]);
 
-                bestlag -= startLag;
+            double pvalue;
+            {
+                TSA_STAGE(PVALUE);
+                pvalue = tools::mackinnon::p_value(adfstat, TT, 1);
+            }
 
-                // rerun OLS with best autolag
-                xdall = tools::lagmat(xdiff, bestlag, "both", "in");
+            std::array<double, 3> critvalues;
+            {
+                TSA_STAGE(CRITVALUE);
+                critvalues = tools::mackinnon::crit_value(1, TT, nobs);
+            }
 
-                //std::cout << "Checking xdall v3 : " << xt::adapt(xdall.shape()) << std::endl;
-                //std::cout << xdall << std::endl;
+            return {adfstat, pvalue, usedlag, nobs, critvalues, icbest};
+        }
 
-                nobs = xdall.shape(0);
-                auto x_len = x.shape()[0];
-                if (x_len < nobs + 1) {
-                    throw std::runtime_error("Not enough observations after lagging");
-                }
-                xt::view(xdall, xt::all(), 0) = xt::view(x, xt::range(x_len - nobs - 1, x_len - 1));
-                xdshort = xt::view(xdiff, xt::range(static_cast<int>(-nobs), xt::all()));
+        // Runtime trend and criterion, dispatched once to the matching specialization
+        template <typename T>
+        inline ADFResult adfuller(const xt::xtensor<T, 1>& x, BasicADFWorkspace<T>& ws, int maxlag,
+                      tools::trendType regression, tools::lagCriterion autolag) {
+            return tools::withTrend(regression, [&](auto t) {
+                return tools::withCriterion(autolag, [&](auto c) {
+                    return adfuller<decltype(t)::value, decltype(c)::value, T>(x, ws, maxlag);
+                });
+            });
+        }
+
+        template <typename T>
+        inline ADFResult adfuller(const xt::xtensor<T, 1>& x, BasicADFWorkspace<T>& ws, int maxlag = 0, std::string regression = "c",
+                      std::string autolag = "AIC", bool store = false, bool regresults = false) {
+            /**
+             * x : 1d array of test data
+             *
+             * maxLag : int, Maximum lag which is included in the test
+             *          default value of 12*(nobs/100)^{1/4} is used when 0.
+             *
+             * regression : {"c", "ct", "ctt", "n"}
+             *          constant and trend order to include in regression
+             *
+             * autolag : {"AIC", "BIC", "t-stat", ""}
+             *          Method to use when automatically determining the lag length among the
+             *          values 0, 1, ..., maxlag, "" or any other value uses maxlag.
+             *
+             * store : bool
+             *         If true then a result instance is returned as well as the ADF stats
+             * regresults : bool
+             *         If true then return the full regression results
+             *
+             * See the templated adfuller for details, the strings are parsed once here.
+             */
 
-                //std::cout << "Checking xdshort v2 : " << xt::adapt(xdshort.shape()) << std::endl;
-                //std::cout << xdshort << std::endl;
+            // initial lines ensure type correctness in python function
+            // will ignore for now are correctness is ensured by type definition for params
 
-                usedlag = bestlag;
-            } else {
-                usedlag = maxlag;
-                icbest = -1.0;
-            }
+            // store regression results so store must be true
+            if (regresults)
+                store = true;
 
-            linModels::RegressionResult resols;
-            if (regression != "n") {
-                auto rhs = tools::addTrend(xt::eval(xt::view(xdall, xt::all(), xt::range(0, usedlag + 1))),
-                                           regression, false);
-                resols = linModels::getModelOfType(linModels::OLS, rhs, xdshort)->fit();
-            } else {
-                auto rhs = xt::view(xdall, xt::all(), xt::range(0, usedlag + 1));
-                resols = linModels::getModelOfType(linModels::OLS, rhs, xdshort)->fit();
+            tools::trendType trend;
+            try {
+                trend = tools::parseTrend(regression);
+            } catch (const std::invalid_argument&) {
+                throw std::invalid_argument("Invalid regression type");
             }
 
-            double adfstat = resols.tValues[0];
+            return adfuller(x, ws, maxlag, trend, detail::parseAutolag(autolag));
+        }
 
-            //std::cout << "Checking ADF stat : " << adfstat << std::endl;
+        inline ADFResult adfuller(xt::xtensor<double, 1> x, int maxlag = 0, std::string regression = "c",
+                      std::string autolag = "AIC", bool store = false, bool regresults = false) {
+            ADFWorkspace ws;
+            return adfuller(x, ws, maxlag, regression, autolag, store, regresults);
+        }
 
-            double pvalue = tools::mackinnon::p_value(adfstat, regression, 1);
+        // Result reported for a series the test cannot be run on, e.g. a constant one
+        inline ADFResult failedResult() {
+            const double nan = std::numeric_limits<double>::quiet_NaN();
+            return {nan, nan, -1, 0, {nan, nan, nan}, nan};
+        }
+
+        template <typename T>
+        inline std::vector<ADFResult> adfullerBatch(const xt::xtensor<T, 2>& panel, int maxlag = 0, std::string regression = "c",
+                      std::string autolag = "AIC", std::size_t nThreads = 0) {
+            /**
+             * panel : 2d array (series, time), each row is tested independently
+             *
+             * nThreads : int, number of worker threads, 0 uses the hardware concurrency
+             *
+             * Remaining arguments are as for adfuller, including the autolag fallback to
+             * no lag selection. Results are returned in row order,
+             * rows that adfuller rejects (constant or too short) get failedResult().
+             * Every data error adfuller raises is a std::invalid_argument, anything
+             * else, e.g. std::bad_alloc or an xtensor shape error, propagates.
+             */
 
-            //std::cout << "checking P value : " << pvalue << std::endl;
+            const tools::trendType trend = tools::parseTrend(regression);
+            const tools::lagCriterion criterion = detail::parseAutolag(autolag);
 
-            xt::xarray<double> critvalues = tools::mackinnon::crit_value(1, regression, nobs);
+            std::size_t nseries = panel.shape(0);
+            std::vector<ADFResult> results(nseries);
+            std::vector<BasicADFWorkspace<T>> ws(tools::workerCount(nseries, nThreads));
 
-            std::map<std::string, double> crits;
-            crits["1%"] = critvalues[0];
-            crits["5%"] = critvalues[1];
-            crits["10%"] = critvalues[2];
+            tools::parallelFor(nseries, nThreads, [&](std::size_t i, std::size_t w) {
+                BasicADFWorkspace<T>& scratch = ws[w];
+                scratch.x = xt::view(panel, i, xt::all());
+                try {
+                    results[i] = adfuller(scratch.x, scratch, maxlag, trend, criterion);
+                } catch (const std::invalid_argument&) {
+                    results[i] = failedResult();
+                }
+            });
+
+            return results;
+        }
+
+        // Ragged input, series may have different lengths
+        template <typename T>
+        inline std::vector<ADFResult> adfullerBatch(const std::vector<xt::xtensor<T, 1>>& series, int maxlag = 0,
+                      std::string regression = "c", std::string autolag = "AIC", std::size_t nThreads = 0) {
+            const tools::trendType trend = tools::parseTrend(regression);
+            const tools::lagCriterion criterion = detail::parseAutolag(autolag);
+
+            std::vector<ADFResult> results(series.size());
+            std::vector<BasicADFWorkspace<T>> ws(tools::workerCount(series.size(), nThreads));
+
+            tools::parallelFor(series.size(), nThreads, [&](std::size_t i, std::size_t w) {
+                try {
+                    results[i] = adfuller(series[i], ws[w], maxlag, trend, criterion);
+                } catch (const std::invalid_argument&) {
+                    results[i] = failedResult();
+                }
+            });
 
-            return {adfstat, pvalue, usedlag, nobs, crits, icbest};
+            return results;
         }
     }
 }
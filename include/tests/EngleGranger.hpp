@@ -0,0 +1,166 @@
+#ifndef ENGLEGRANGER_H_
+#define ENGLEGRANGER_H_
+
+/**
+ * Engle-Granger cointegration screen
+ *
+ * Two price series are cointegrated when some linear combination of them,
+ * the spread, is stationary. The Engle-Granger procedure estimates the hedge
+ * ratio by OLS and then runs an ADF test without deterministic terms on the
+ * regression residuals. As the residuals come from an estimated relation the
+ * MacKinnon p-value is taken with constant and N = 2 variables.
+ *
+ * Screening all N (N - 1) / 2 pairs is dominated by the ADF step, so pairs are
+ * first filtered with the correlation matrix of the panel, which one BLAS
+ * product gives for every pair. The same moments give the OLS hedge ratio
+ * beta = corr * sd_y / sd_x without any further regression.
+ */
+
+#include "ADFT.hpp"
+#include "Hurst.hpp"
+#include "../tools/autoReg.hpp"
+#include "../tools/MacKinnonValues.hpp"
+#include "../tools/parallel.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include <xtensor/containers/xtensor.hpp>
+#include <xtensor/views/xview.hpp>
+#include <xtensor-blas/xlinalg.hpp>
+
+namespace tests {
+
+    namespace coint {
+
+        struct PairResult {
+            std::size_t i; // dependent series, y
+            std::size_t j; // independent series, x
+
+            double corr;
+
+            // hedge regression y = alpha + beta x
+            double alpha;
+            double beta;
+
+            double adfstat;
+            double pvalue;
+            int usedlag;
+
+            double halfLife;
+            double hurst; // NaN when the spread is too short for the Hurst lags
+        };
+
+        struct EGConfig {
+            double minAbsCorr = 0.7; // pairs below this absolute correlation skip the ADF step
+            double maxPValue = 1.0; // pairs above this p-value are dropped from the output
+
+            int maxlag = 0; // as for adfuller
+            std::string autolag = "AIC"; // as for adfuller
+
+            std::size_t nThreads = 0; // 0 uses the hardware concurrency
+            std::size_t grain = 16; // consecutive pairs per task, pairs are ordered by i
+        };
+
+        // Per worker scratch
+        struct EGWorkspace {
+            xt::xtensor<double, 1> spread;
+            adf::ADFWorkspace adf;
+        };
+
+        inline std::vector<PairResult> engleGrangerScreen(const xt::xtensor<double, 2>& prices, const EGConfig& cfg = EGConfig()) {
+            /**
+             * prices : 2d array (series, time) of price levels
+             *
+             * cfg : EGConfig, screening thresholds and threading
+             *
+             * Returns ...
+             *
+             * Surviving pairs (i < j) ranked by ascending p-value
+             */
+
+            const std::size_t N = prices.shape(0);
+            const std::size_t T = prices.shape(1);
+            if (T < 3)
+                throw std::invalid_argument("tests::coint::engleGrangerScreen : Series are too short.");
+
+            // standardise rows so that Z Z^{t} is the correlation matrix
+            xt::xtensor<double, 1> means = xt::mean(prices, {1});
+            xt::xtensor<double, 1> sds = xt::stddev(prices, {1});
+            xt::xtensor<double, 2> Z = prices - xt::view(means, xt::all(), xt::newaxis());
+            for (std::size_t i = 0; i < N; ++i) {
+                double scale = (sds(i) > 0.0) ? 1.0 / (sds(i) * std::sqrt(static_cast<double>(T))) : 0.0;
+                xt::view(Z, i, xt::all()) *= scale;
+            }
+            xt::xtensor<double, 2> C = xt::linalg::dot(Z, xt::transpose(Z));
+
+            // cheap pre-filter, constant series have zero rows in Z and never pass
+            std::vector<std::pair<std::size_t, std::size_t>> candidates;
+            for (std::size_t i = 0; i < N; ++i) {
+                for (std::size_t j = i + 1; j < N; ++j) {
+                    if (sds(i) > 0.0 && sds(j) > 0.0 && std::abs(C(i, j)) >= cfg.minAbsCorr)
+                        candidates.emplace_back(i, j);
+                }
+            }
+
+            const tools::lagCriterion criterion = adf::detail::parseAutolag(cfg.autolag);
+            const std::vector<int> hurstLags = tools::linearLags(2, 99);
+
+            const std::size_t workers = tools::workerCount(candidates.size(), cfg.nThreads, cfg.grain);
+            std::vector<EGWorkspace> ws(workers);
+            std::vector<std::vector<PairResult>> found(workers);
+            const double nan = std::numeric_limits<double>::quiet_NaN();
+
+            tools::parallelFor(candidates.size(), cfg.nThreads, [&](std::size_t c, std::size_t w) {
+                const std::size_t i = candidates[c].first;
+                const std::size_t j = candidates[c].second;
+                EGWorkspace& scratch = ws[w];
+
+                PairResult r;
+                r.i = i;
+                r.j = j;
+                r.corr = C(i, j);
+                r.beta = r.corr * sds(i) / sds(j);
+                r.alpha = means(i) - r.beta * means(j);
+
+                scratch.spread = xt::view(prices, i, xt::all()) - r.beta * xt::view(prices, j, xt::all()) - r.alpha;
+
+                try {
+                    adf::ADFResult res = adf::adfuller(scratch.spread, scratch.adf, cfg.maxlag, tools::trendType::N, criterion);
+                    r.adfstat = res.adfstat;
+                    r.usedlag = res.usedlag;
+                } catch (const std::invalid_argument&) {
+                    return; // degenerate spread
+                }
+
+                r.pvalue = tools::mackinnon::p_value(r.adfstat, tools::trendType::C, 2);
+                if (r.pvalue > cfg.maxPValue)
+                    return;
+
+                r.halfLife = tools::AROneHalfLife(scratch.spread);
+                r.hurst = (T > 100) ? tests::hurst(scratch.spread.data(), T, hurstLags) : nan;
+
+                found[w].push_back(r);
+            }, cfg.grain);
+
+            std::vector<PairResult> ranked;
+            for (auto& f : found)
+                ranked.insert(ranked.end(), f.begin(), f.end());
+
+            std::sort(ranked.begin(), ranked.end(), [](const PairResult& a, const PairResult& b) {
+                if (a.pvalue != b.pvalue)
+                    return a.pvalue < b.pvalue;
+                return a.adfstat < b.adfstat;
+            });
+
+            return ranked;
+        }
+    }
+}
+
+#endif // ENGLEGRANGER_H_
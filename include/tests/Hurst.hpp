@@ -1,12 +1,12 @@
 #ifndef HURST_H_
 #define HURST_H_
 
-#include "../tools/npTools.hpp"
+#include "../tools/lagVariance.hpp"
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
 #include <xtensor/containers/xarray.hpp>
-#include <xtensor/core/xmath.hpp>
-#include <xtensor/io/xio.hpp>
-#include <xtensor/views/xview.hpp>
-#include <xtensor/containers/xadapt.hpp>
+#include <xtensor/containers/xtensor.hpp>
 
 namespace tests {
 
@@ -23,32 +23,71 @@ namespace tests {
      *  - H > 0.5 : Trending
      *
      */
-    inline double hurst(const xt::xarray<double>& ts) {
+    template <typename T>
+    inline T hurst(const T* ts, std::size_t n, const std::vector<int>& lags, std::size_t nThreads = 1) {
         /*
-         * ts : xarray<double>
-         *     - Time series upon which the Hurst Exponent will be calculated
+         * ts : pointer to n contiguous observations
+         *
+         * lags : lag grid, e.g. tools::linearLags or tools::logLags, each lag in [1, n - 1)
+         *
+         * nThreads : workers the lags are split over, worthwhile for long series,
+         *      0 uses the hardware concurrency
          *
          * Returns ...
          *
-         * 'double'
-         *     - The Hurst Exponent from the poly fit output
+         * 'T'
+         *     - The Hurst Exponent from the log-log fit of sqrt(stddev) against the lags
          *
          */
 
-        xt::xarray<int> lags = xt::arange(2, 100, 1);
+        std::vector<T> var(lags.size());
+        tools::lagDiffVariance(ts, n, lags, var.data(), nThreads);
+
+        // Having issues with hurst being negative ....
+        return tools::hurstFromVariance(lags, var.data());
+    }
 
-        std::vector<double> tau_vec;
-        for (int lag : lags) {
-            auto diff = xt::view(ts, xt::range(lag, xt::all())) - xt::view(ts, xt::range(0, ts.size() - lag));
-             tau_vec.push_back(std::sqrt(xt::stddev(diff)()));
-        }
+    template <typename T>
+    inline T hurst(const xt::xarray<T>& ts, const std::vector<int>& lags, std::size_t nThreads = 1) {
+        if (ts.dimension() != 1)
+            throw std::invalid_argument("tests::hurst : ts must be one-dimensional.");
+        return hurst(ts.data(), ts.size(), lags, nThreads);
+    }
 
-        xt::xarray<double> tau_x = xt::adapt(tau_vec);
+    template <typename T>
+    inline T hurst(const xt::xtensor<T, 1>& ts, const std::vector<int>& lags, std::size_t nThreads = 1) {
+        return hurst(ts.data(), ts.size(), lags, nThreads);
+    }
 
-        xt::xarray<double> poly = tools::np::polyfit(xt::log(lags), xt::log(tau_x), 1);
+    // Lags 2, ..., 99
+    inline const std::vector<int>& defaultHurstLags() {
+        static const std::vector<int> lags = tools::linearLags(2, 99);
+        return lags;
+    }
 
-        // Having issues with hurst being negative ....
-        return std::max(0.0, poly[0]*2.0);
+    template <typename T>
+    inline T hurst(const xt::xtensor<T, 1>& ts) {
+        return hurst(ts, defaultHurstLags());
+    }
+
+    template <typename T>
+    inline T hurst(const xt::xarray<T>& ts) {
+        return hurst(ts, defaultHurstLags());
+    }
+
+    inline double hurst(const xt::xarray<double>& ts) {
+        /*
+         * ts : xarray<double>
+         *     - Time series upon which the Hurst Exponent will be calculated
+         *
+         * Returns ...
+         *
+         * 'double'
+         *     - The Hurst Exponent over the default lags 2, ..., 99
+         *
+         */
+
+        return hurst<double>(ts, defaultHurstLags());
     }
 };
 
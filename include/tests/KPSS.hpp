@@ -0,0 +1,219 @@
+#ifndef KPSS_H_
+#define KPSS_H_
+
+/**
+ * Kwiatkowski-Phillips-Schmidt-Shin test
+ *
+ * The null hypothesis is that the series is stationary around a level (c) or a
+ * linear trend (ct), the complement of the ADF unit root null, so the two are
+ * run together to confirm a classification.
+ *
+ * The statistic is sum_t S_t^2 / (n^2 s^2) with S_t the partial sums of the
+ * residuals of the deterministic fit and s^2 their Newey-West long run variance.
+ * The fit on [1, t] has a closed form, so the residuals, partial sums and the
+ * numerator come out of two passes over the series, and every autocovariance of
+ * the Bartlett sum out of one more, with no design matrix or factorization.
+ */
+
+#include "../tools/KPSSValues.hpp"
+#include "../tools/longRunVariance.hpp"
+#include "../tools/parallel.hpp"
+#include "../tools/trend.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cctype>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <xtensor/containers/xtensor.hpp>
+
+namespace tests {
+
+    struct KPSSResult {
+        double kpssstat;
+        double pvalue;
+        int lags;
+        std::array<double, 4> critvalues; // 10%, 5%, 2.5% and 1%, as tools::kpss::crit_value
+
+        // Critical values keyed "10%", "5%", "2.5%" and "1%"
+        std::map<std::string, double> critvaluesMap() const {
+            return {{"10%", critvalues[0]}, {"5%", critvalues[1]}, {"2.5%", critvalues[2]}, {"1%", critvalues[3]}};
+        }
+    };
+
+    // Scratch reused across kpss calls, one per thread
+    template <typename T>
+    struct BasicKPSSWorkspace {
+        std::vector<T> resid; // residuals of the deterministic fit
+        std::vector<T> gamma; // autocovariances of the residuals
+    };
+
+    using KPSSWorkspace = BasicKPSSWorkspace<double>;
+
+    // nlags value selecting the Hobijn et al. (1998) bandwidth
+    inline constexpr int kpssAutoLags = -1;
+
+    namespace detail {
+
+        // "auto", "legacy" or a lag count, resolved for a series of n observations
+        inline int parseKPSSLags(const std::string& nlags, std::size_t n) {
+            if (nlags == "auto")
+                return kpssAutoLags;
+            if (nlags == "legacy")
+                return static_cast<int>(std::min(tools::schwertLags(n), n - 1));
+            if (nlags.empty() || !std::all_of(nlags.begin(), nlags.end(), [](unsigned char c) {return std::isdigit(c);}))
+                throw std::invalid_argument("tests::kpss : nlags must be 'auto', 'legacy' or a non-negative integer.");
+            return std::stoi(nlags);
+        }
+
+        inline void checkKPSSRegression(tools::trendType regression) {
+            if (regression != tools::trendType::C && regression != tools::trendType::CT)
+                throw std::invalid_argument("tests::kpss : Regression must be 'c' or 'ct'.");
+        }
+
+        inline KPSSResult failedKPSS() {
+            const double nan = std::numeric_limits<double>::quiet_NaN();
+            return {nan, nan, -1, {nan, nan, nan, nan}};
+        }
+    }
+
+    template <typename T>
+    inline KPSSResult kpss(const T* x, std::size_t n, BasicKPSSWorkspace<T>& ws,
+                           tools::trendType regression = tools::trendType::C, int nlags = kpssAutoLags) {
+        /**
+         * x : pointer to n contiguous observations
+         *
+         * regression : tools::trendType, C for level and CT for trend stationarity
+         *
+         * nlags : int, lags of the Bartlett long run variance, kpssAutoLags selects
+         *         them from the data as in Hobijn et al. (1998)
+         *
+         * Returns the statistic, its p-value interpolated in the KPSS table and
+         * clamped to [0.01, 0.10], the lags used and the critical values.
+         */
+
+        detail::checkKPSSRegression(regression);
+        if (n < 3)
+            throw std::invalid_argument("tests::kpss : At least 3 observations are required.");
+        if (nlags != kpssAutoLags && (nlags < 0 || static_cast<std::size_t>(nlags) >= n))
+            throw std::invalid_argument("tests::kpss : nlags must be less than the number of observations.");
+
+        // sums about x[0] to limit cancellation for price levels
+        const T ref = x[0];
+        const T tbar = static_cast<T>(n - 1) / 2;
+        T sum = 0.0, sumTX = 0.0;
+        for (std::size_t t = 0; t < n; ++t) {
+            T y = x[t] - ref;
+            sum += y;
+            sumTX += (static_cast<T>(t) - tbar) * y;
+        }
+        const T mean = sum / static_cast<T>(n);
+
+        // OLS slope on the centred trend, sum (t - tbar)^2 = n (n^2 - 1) / 12
+        T slope = 0.0;
+        if (regression == tools::trendType::CT) {
+            const T nn = static_cast<T>(n);
+            slope = sumTX / (nn * (nn * nn - 1) / 12);
+        }
+
+        ws.resid.resize(n);
+        T partial = 0.0, eta = 0.0;
+        for (std::size_t t = 0; t < n; ++t) {
+            T r = x[t] - ref - mean - slope * (static_cast<T>(t) - tbar);
+            ws.resid[t] = r;
+            partial += r;
+            eta += partial * partial;
+        }
+
+        // every autocovariance the bandwidth rule and the Bartlett sum need in one sweep
+        std::size_t lags;
+        if (nlags == kpssAutoLags) {
+            const std::size_t covLags = std::min(tools::hobijnCovLags(n), n - 1);
+            ws.gamma.resize(covLags + 1);
+            tools::autocovariances(ws.resid.data(), n, 0, covLags, ws.gamma.data());
+            lags = std::min(tools::hobijnLags(ws.gamma.data(), n), n - 1);
+            if (lags > covLags) {
+                ws.gamma.resize(lags + 1);
+                tools::autocovariances(ws.resid.data(), n, covLags + 1, lags, ws.gamma.data());
+            }
+        } else {
+            lags = static_cast<std::size_t>(nlags);
+            ws.gamma.resize(lags + 1);
+            tools::autocovariances(ws.resid.data(), n, 0, lags, ws.gamma.data());
+        }
+
+        const T s2 = tools::bartlettLongRunVariance(ws.gamma.data(), lags);
+        if (!(s2 > 0.0))
+            throw std::invalid_argument("tests::kpss : Residuals have no variance, x is constant or an exact trend.");
+
+        const double nd = static_cast<double>(n);
+        const double stat = static_cast<double>(eta) / (nd * nd) / static_cast<double>(s2);
+
+        return {stat, tools::kpss::p_value(stat, regression), static_cast<int>(lags), tools::kpss::crit_value(regression)};
+    }
+
+    template <typename T>
+    inline KPSSResult kpss(const xt::xtensor<T, 1>& x, BasicKPSSWorkspace<T>& ws,
+                           tools::trendType regression = tools::trendType::C, int nlags = kpssAutoLags) {
+        return kpss(x.data(), x.size(), ws, regression, nlags);
+    }
+
+    template <typename T>
+    inline KPSSResult kpss(const xt::xtensor<T, 1>& x, std::string regression = "c", std::string nlags = "auto") {
+        /**
+         * x : 1d array of test data
+         *
+         * regression : {"c", "ct"}, level or trend stationarity under the null
+         *
+         * nlags : {"auto", "legacy"} or an integer as a string
+         *
+         *          * auto : bandwidth of Hobijn et al. (1998)
+         *          * legacy : ceil(12 (n / 100)^{1/4})
+         */
+
+        BasicKPSSWorkspace<T> ws;
+        return kpss(x, ws, tools::parseTrend(regression), detail::parseKPSSLags(nlags, x.size()));
+    }
+
+    template <typename T>
+    inline std::vector<KPSSResult> kpssBatch(const xt::xtensor<T, 2>& panel, std::string regression = "c",
+                                             std::string nlags = "auto", std::size_t nThreads = 0) {
+        /**
+         * panel : 2d array (series, time), each row is tested independently
+         *
+         * nThreads : int, number of worker threads, 0 uses the hardware concurrency
+         *
+         * Remaining arguments are as for kpss. Results are returned in row order,
+         * rows kpss rejects (constant or too short) get NaN statistics. A regression
+         * other than c or ct throws before any row is tested, and failures that are
+         * not data errors, e.g. std::bad_alloc, propagate.
+         */
+
+        const tools::trendType trend = tools::parseTrend(regression);
+        detail::checkKPSSRegression(trend);
+        const std::size_t nseries = panel.shape(0);
+        const std::size_t n = panel.shape(1);
+        const int lags = detail::parseKPSSLags(nlags, n);
+
+        std::vector<KPSSResult> results(nseries);
+        std::vector<BasicKPSSWorkspace<T>> ws(tools::workerCount(nseries, nThreads));
+
+        tools::parallelFor(nseries, nThreads, [&](std::size_t i, std::size_t w) {
+            try {
+                results[i] = kpss(panel.data() + i * n, n, ws[w], trend, lags);
+            } catch (const std::invalid_argument&) {
+                results[i] = detail::failedKPSS();
+            }
+        });
+
+        return results;
+    }
+}
+
+#endif // KPSS_H_
@@ -0,0 +1,222 @@
+#ifndef PHILLIPSPERRON_H_
+#define PHILLIPSPERRON_H_
+
+/**
+ * Phillips-Perron unit root test
+ *
+ * Fits the Dickey-Fuller regression without lagged differences and corrects the
+ * statistic for serial correlation and heteroskedasticity of the errors with a
+ * Newey-West estimate of their long run variance, instead of searching over
+ * augmentation lags as adfuller does. The regression is adfuller's own, through
+ * the same workspace, and the long run variance takes every autocovariance of
+ * the residuals in one sweep, so the cost is one OLS fit and one pass per lag
+ * block regardless of the bandwidth.
+ *
+ * With rho = alpha - 1 the level coefficient, se its standard error, s^2 the
+ * residual variance, gamma_0 = RSS / n and lambda^2 the long run variance
+ *
+ *     Z_tau = sqrt(gamma_0 / lambda^2) rho / se - (lambda^2 - gamma_0) n se / (2 lambda s)
+ *     Z_rho = n rho - n^2 se^2 (lambda^2 - gamma_0) / (2 s^2)
+ *
+ * Z_tau has the ADF t distribution and Z_rho the normalized bias distribution.
+ */
+
+#include "ADFT.hpp"
+#include "../tools/MacKinnonValues.hpp"
+#include "../tools/longRunVariance.hpp"
+#include "../tools/parallel.hpp"
+#include "../tools/trend.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <map>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <xtensor/containers/xtensor.hpp>
+
+namespace tests {
+
+    // Statistic reported by the Phillips-Perron test
+    enum class ppTestType {
+        TAU, // t statistic of the level coefficient
+        RHO // normalized bias n (alpha - 1)
+    };
+
+    struct PPResult {
+        double stat;
+        double pvalue;
+        int lags;
+        std::size_t nobs;
+        std::array<double, 3> critvalues; // 1%, 5% and 10%, as adf::ADFResult
+
+        // Critical values keyed "1%", "5%" and "10%"
+        std::map<std::string, double> critvaluesMap() const {
+            return {{"1%", critvalues[0]}, {"5%", critvalues[1]}, {"10%", critvalues[2]}};
+        }
+    };
+
+    namespace detail {
+
+        inline ppTestType parsePPTest(const std::string& s) {
+            if (tools::detail::iequals(s, "tau")) return ppTestType::TAU;
+            if (tools::detail::iequals(s, "rho")) return ppTestType::RHO;
+            throw std::invalid_argument("tests::pp : Test type must be 'tau' or 'rho'.");
+        }
+
+        inline PPResult failedPP() {
+            const double nan = std::numeric_limits<double>::quiet_NaN();
+            return {nan, nan, -1, 0, {nan, nan, nan}};
+        }
+    }
+
+    template <tools::trendType TT, typename T>
+    inline PPResult pp(const xt::xtensor<T, 1>& x, adf::BasicADFWorkspace<T>& ws, int lags = -1,
+                       ppTestType testType = ppTestType::TAU) {
+        /**
+         * x : 1d array of test data
+         *
+         * lags : int, Bartlett bandwidth of the long run variance,
+         *        -1 uses ceil(12 (n / 100)^{1/4}) for n observations
+         *
+         * TT : tools::trendType, deterministic terms as for adfuller
+         *
+         * testType : TAU for the t statistic, RHO for the normalized bias
+         */
+
+        constexpr std::size_t ntrend = tools::trendTraits<TT>::ntrend;
+
+        auto range = std::minmax_element(x.begin(), x.end());
+        if (range.first == x.end() || *range.first == *range.second)
+            throw std::invalid_argument("tests::pp : Invalid input, x is constant.");
+
+        const std::size_t xlen = x.shape(0);
+        const std::size_t nobs = xlen - 1;
+        const std::size_t k = 1 + ntrend;
+        if (nobs <= k + 1)
+            throw std::invalid_argument("tests::pp : Sample size is too short for the regression.");
+
+        std::size_t nlags = lags < 0 ? tools::schwertLags(xlen) : static_cast<std::size_t>(lags);
+        nlags = std::min(nlags, nobs - 1);
+
+        // Dickey-Fuller regression with no augmentation, the level coefficient first
+        adf::detail::difference(x, ws);
+        adf::detail::fitLag<TT>(x.data(), ws, 0);
+        const linModels::BasicRegressionResult<T>& res = ws.res;
+
+        // the residuals only have zero mean when the regression has a constant, the
+        // long run variance is taken about their mean either way while gamma_0 stays
+        // the raw RSS / n
+        const T* resid = res.residuals.data();
+        T rss = 0.0;
+        if constexpr (ntrend == 0) {
+            T sum = 0.0;
+            for (std::size_t t = 0; t < nobs; ++t) {
+                sum += resid[t];
+                rss += resid[t] * resid[t];
+            }
+            const T mean = sum / static_cast<T>(nobs);
+
+            ws.centred.resize(nobs);
+            for (std::size_t t = 0; t < nobs; ++t)
+                ws.centred[t] = resid[t] - mean;
+            resid = ws.centred.data();
+        }
+
+        ws.gamma.resize(nlags + 1);
+        tools::autocovariances(resid, nobs, 0, nlags, ws.gamma.data());
+        if constexpr (ntrend > 0)
+            rss = ws.gamma[0] * static_cast<T>(nobs);
+
+        const double n = static_cast<double>(nobs);
+        const double rho = static_cast<double>(res.params(0));
+        const double se = static_cast<double>(res.stdErrors(0));
+        const double gamma0 = static_cast<double>(rss) / n;
+        const double lam2 = static_cast<double>(tools::bartlettLongRunVariance(ws.gamma.data(), nlags));
+        const double s2 = gamma0 * n / (n - static_cast<double>(k));
+
+        if (!(lam2 > 0.0) || !(s2 > 0.0))
+            throw std::invalid_argument("tests::pp : Residual long run variance is not positive.");
+
+        double stat;
+        std::array<double, 3> critvalues;
+        double pvalue;
+        if (testType == ppTestType::TAU) {
+            const double lam = std::sqrt(lam2);
+            stat = std::sqrt(gamma0 / lam2) * (rho / se) - 0.5 * ((lam2 - gamma0) / lam) * (n * se / std::sqrt(s2));
+            pvalue = tools::mackinnon::p_value(stat, TT, 1);
+            critvalues = tools::mackinnon::crit_value(1, TT, n);
+        } else {
+            stat = n * rho - 0.5 * (n * n * se * se / s2) * (lam2 - gamma0);
+            pvalue = tools::mackinnon::z_p_value(stat, TT);
+            critvalues = tools::mackinnon::z_crit_value(TT);
+        }
+
+        return {stat, pvalue, static_cast<int>(nlags), nobs, critvalues};
+    }
+
+    // Runtime trend, dispatched once to the matching specialization
+    template <typename T>
+    inline PPResult pp(const xt::xtensor<T, 1>& x, adf::BasicADFWorkspace<T>& ws, int lags,
+                       tools::trendType regression, ppTestType testType = ppTestType::TAU) {
+        return tools::withTrend(regression, [&](auto t) {
+            return pp<decltype(t)::value, T>(x, ws, lags, testType);
+        });
+    }
+
+    template <typename T>
+    inline PPResult pp(const xt::xtensor<T, 1>& x, int lags = -1, std::string regression = "c",
+                       std::string testType = "tau") {
+        /**
+         * x : 1d array of test data
+         *
+         * lags : int, Bartlett bandwidth, -1 uses ceil(12 (n / 100)^{1/4}) for n observations
+         *
+         * regression : {"c", "ct", "ctt", "n"}, deterministic terms as for adfuller
+         *
+         * testType : {"tau", "rho"}
+         */
+
+        adf::BasicADFWorkspace<T> ws;
+        return pp(x, ws, lags, tools::parseTrend(regression), detail::parsePPTest(testType));
+    }
+
+    template <typename T>
+    inline std::vector<PPResult> ppBatch(const xt::xtensor<T, 2>& panel, int lags = -1, std::string regression = "c",
+                                         std::string testType = "tau", std::size_t nThreads = 0) {
+        /**
+         * panel : 2d array (series, time), each row is tested independently
+         *
+         * nThreads : int, number of worker threads, 0 uses the hardware concurrency
+         *
+         * Remaining arguments are as for pp. Results are returned in row order, rows
+         * pp rejects (constant or too short) get NaN statistics. Failures that are
+         * not data errors, e.g. std::bad_alloc, propagate.
+         */
+
+        const tools::trendType trend = tools::parseTrend(regression);
+        const ppTestType type = detail::parsePPTest(testType);
+
+        const std::size_t nseries = panel.shape(0);
+        std::vector<PPResult> results(nseries);
+        std::vector<adf::BasicADFWorkspace<T>> ws(tools::workerCount(nseries, nThreads));
+
+        tools::parallelFor(nseries, nThreads, [&](std::size_t i, std::size_t w) {
+            adf::BasicADFWorkspace<T>& scratch = ws[w];
+            scratch.x = xt::view(panel, i, xt::all());
+            try {
+                results[i] = pp(scratch.x, scratch, lags, trend, type);
+            } catch (const std::invalid_argument&) {
+                results[i] = detail::failedPP();
+            }
+        });
+
+        return results;
+    }
+}
+
+#endif // PHILLIPSPERRON_H_
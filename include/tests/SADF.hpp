@@ -0,0 +1,377 @@
+#ifndef SADF_H_
+#define SADF_H_
+
+/**
+ * Supremum ADF tests for explosive behaviour, Phillips, Shi and Yu (2015)
+ *
+ * SADF is the supremum of ADF statistics over forward expanding windows that
+ * start at the first observation, GSADF the supremum over every window of at
+ * least minWindow observations. The backward sequence BSADF_e, the supremum over
+ * the windows ending at e, dates the bubble episodes.
+ *
+ * Each window runs the ADF regression of adfuller with a fixed lag. The rows of
+ * that regression are shared by every window, they are built once, and for a
+ * given start the fit is extended one row at a time by a Givens update of the R
+ * factor of [X y]. With the level column placed last the ADF statistic is read
+ * off the last row of the factor in O(1), so a start costs O(n k^2) for all of
+ * its ends instead of one regression per window. Start points are spread across
+ * threads.
+ */
+
+#include "../models/linear/solvers.hpp"
+#include "../tools/parallel.hpp"
+#include "../tools/trend.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <xtensor/containers/xtensor.hpp>
+
+namespace tests {
+
+    namespace adf {
+
+        struct SADFResult {
+            double stat; // SADF or GSADF
+            std::size_t minWindow;
+            int lag;
+            // ADF_e from the first observation (SADF) or BSADF_e (GSADF) for each end e,
+            // NaN before the first full window
+            xt::xtensor<double, 1> sequence;
+        };
+
+        // Smallest window of the PSY recommendation r0 = 0.01 + 1.8 / sqrt(n)
+        inline std::size_t defaultMinWindow(std::size_t n) {
+            double r0 = 0.01 + 1.8 / std::sqrt(static_cast<double>(n));
+            return static_cast<std::size_t>(std::floor(r0 * static_cast<double>(n)));
+        }
+
+        namespace detail {
+
+            // Regressors of the ADF regression plus the dependent variable
+            inline std::size_t sadfWidth(tools::trendType trend, int lag) {
+                return tools::ntrendOf(trend) + static_cast<std::size_t>(lag) + 2;
+            }
+
+            // Row of the ADF regression for Delta y_t, yt points at y_t
+            //
+            // Columns are the deterministic terms, the lagged differences, the level
+            // y_{t-1} - ref and Delta y_t. tau is the trend value of t, any affine map
+            // of t gives the same statistic as the trend terms span the shift.
+            template <typename T>
+            inline void sadfRow(T* row, const T* yt, std::size_t ntrend, int lag, T tau, T ref) {
+                std::size_t c = 0;
+                if (ntrend > 0)
+                    row[c++] = 1.0;
+                if (ntrend > 1)
+                    row[c++] = tau;
+                if (ntrend > 2)
+                    row[c++] = tau * tau;
+                for (int j = 1; j <= lag; ++j)
+                    row[c++] = yt[-j] - yt[-j - 1];
+                row[c++] = yt[-1] - ref;
+                row[c] = yt[0] - yt[-1];
+            }
+
+            // t statistic of the level coefficient from the (m, m) factor of [X y] over nobs rows
+            //
+            // With L = [[Lx, 0], [l^{t}, d]] the level coefficient is l_{k} / Lx_{kk}, its
+            // variance s^2 / Lx_{kk}^2 and RSS = d^2, so t = l_{k} sqrt(nobs - k) / d.
+            template <typename T>
+            inline double levelTStat(const T* L, std::size_t m, std::size_t nobs) {
+                const std::size_t k = m - 1;
+                if (nobs <= k)
+                    return std::numeric_limits<double>::quiet_NaN();
+                for (std::size_t j = 0; j < m; ++j) {
+                    if (!(L[j * m + j] > 0.0))
+                        return std::numeric_limits<double>::quiet_NaN();
+                }
+                double l = static_cast<double>(L[k * m + k - 1]);
+                double d = static_cast<double>(L[k * m + k]);
+                return l * std::sqrt(static_cast<double>(nobs - k)) / d;
+            }
+
+            inline void checkWindow(std::size_t n, std::size_t minWindow, tools::trendType trend, int lag) {
+                if (lag < 0)
+                    throw std::invalid_argument("tests::adf::sadf : lag must be non-negative.");
+                // a window of w observations gives w - lag - 1 rows for k regressors
+                if (minWindow < sadfWidth(trend, lag) + static_cast<std::size_t>(lag) + 1)
+                    throw std::invalid_argument("tests::adf::sadf : minWindow is too short for the regression.");
+                if (minWindow > n)
+                    throw std::invalid_argument("tests::adf::sadf : minWindow exceeds the sample size.");
+            }
+
+            // Rows of the ADF regression for t = lag + 1, ..., n - 1, row major (n - lag - 1, m)
+            template <typename T>
+            inline std::vector<T> sadfDesign(const xt::xtensor<T, 1>& y, tools::trendType trend, int lag) {
+                const std::size_t n = y.size();
+                const std::size_t m = sadfWidth(trend, lag);
+                const std::size_t ntrend = tools::ntrendOf(trend);
+                const std::size_t first = static_cast<std::size_t>(lag) + 1;
+                // the level only shifts the intercept when there is one
+                const T ref = ntrend > 0 ? y(0) : T(0);
+                const T scale = T(1) / static_cast<T>(n);
+
+                std::vector<T> D((n - first) * m);
+                for (std::size_t t = first; t < n; ++t)
+                    sadfRow(D.data() + (t - first) * m, y.data() + t, ntrend, lag, static_cast<T>(t) * scale, ref);
+                return D;
+            }
+
+            // ADF statistics of the windows [s, e] for every e, passed to f(e, stat)
+            template <typename T, typename F>
+            inline void sadfForward(const std::vector<T>& D, std::size_t m, std::size_t n, int lag,
+                                    std::size_t s, std::size_t minWindow, T* L, T* x, F&& f) {
+                const std::size_t first = static_cast<std::size_t>(lag) + 1;
+                std::fill(L, L + m * m, T(0));
+                std::size_t nobs = 0;
+                for (std::size_t t = s + first; t < n; ++t) {
+                    const T* row = D.data() + (t - first) * m;
+                    std::copy(row, row + m, x);
+                    linModels::solvers::cholUpdate(L, m, x);
+                    ++nobs;
+                    if (t + 1 >= s + minWindow)
+                        f(t, levelTStat(L, m, nobs));
+                }
+            }
+        }
+
+        template <typename T>
+        inline SADFResult sadf(const xt::xtensor<T, 1>& y, std::size_t minWindow = 0, int lag = 0,
+                               tools::trendType trend = tools::trendType::C) {
+            /**
+             * y : 1d array, the series in levels
+             *
+             * minWindow : int, observations in the first window, 0 uses defaultMinWindow
+             *
+             * lag : int, lagged differences in every ADF regression
+             *
+             * trend : tools::trendType, deterministic terms as for adfuller, PSY use C
+             *
+             * Returns the supremum of ADF_e over the windows [0, e] and the sequence ADF_e.
+             */
+
+            const std::size_t n = y.size();
+            if (minWindow == 0)
+                minWindow = defaultMinWindow(n);
+            detail::checkWindow(n, minWindow, trend, lag);
+
+            const std::size_t m = detail::sadfWidth(trend, lag);
+            const std::vector<T> D = detail::sadfDesign(y, trend, lag);
+            std::vector<T> L(m * m), x(m);
+
+            const double nan = std::numeric_limits<double>::quiet_NaN();
+            SADFResult res{nan, minWindow, lag, xt::empty<double>({n})};
+            std::fill(res.sequence.begin(), res.sequence.end(), nan);
+
+            double best = -std::numeric_limits<double>::infinity();
+            detail::sadfForward(D, m, n, lag, 0, minWindow, L.data(), x.data(), [&](std::size_t e, double stat) {
+                res.sequence(e) = stat;
+                if (stat > best)
+                    best = stat;
+            });
+            if (best > -std::numeric_limits<double>::infinity())
+                res.stat = best;
+            return res;
+        }
+
+        template <typename T>
+        inline SADFResult gsadf(const xt::xtensor<T, 1>& y, std::size_t minWindow = 0, int lag = 0,
+                                tools::trendType trend = tools::trendType::C, std::size_t nThreads = 0) {
+            /**
+             * y : 1d array, the series in levels
+             *
+             * minWindow : int, smallest window, 0 uses defaultMinWindow
+             *
+             * lag : int, lagged differences in every ADF regression
+             *
+             * trend : tools::trendType, deterministic terms as for adfuller, PSY use C
+             *
+             * nThreads : int, number of worker threads, 0 uses the hardware concurrency
+             *
+             * Returns GSADF and the backward sequence BSADF_e, the supremum of the ADF
+             * statistics of the windows [s, e] over s = 0, ..., e - minWindow + 1. Every
+             * start point runs forward on its own worker and the suprema per end are
+             * merged at the end, so the result does not depend on nThreads.
+             */
+
+            const std::size_t n = y.size();
+            if (minWindow == 0)
+                minWindow = defaultMinWindow(n);
+            detail::checkWindow(n, minWindow, trend, lag);
+
+            const std::size_t m = detail::sadfWidth(trend, lag);
+            const std::vector<T> D = detail::sadfDesign(y, trend, lag);
+
+            const double ninf = -std::numeric_limits<double>::infinity();
+            const std::size_t nStarts = n - minWindow + 1;
+            const std::size_t workers = tools::workerCount(nStarts, nThreads);
+
+            // per worker factor, update vector and suprema by end
+            std::vector<std::vector<T>> L(workers, std::vector<T>(m * m));
+            std::vector<std::vector<T>> x(workers, std::vector<T>(m));
+            std::vector<std::vector<double>> sup(workers, std::vector<double>(n, ninf));
+
+            // earlier starts have the most ends, handing them out first balances the workers
+            tools::parallelFor(nStarts, nThreads, [&](std::size_t s, std::size_t w) {
+                double* sw = sup[w].data();
+                detail::sadfForward(D, m, n, lag, s, minWindow, L[w].data(), x[w].data(), [&](std::size_t e, double stat) {
+                    if (stat > sw[e])
+                        sw[e] = stat;
+                });
+            });
+
+            const double nan = std::numeric_limits<double>::quiet_NaN();
+            SADFResult res{nan, minWindow, lag, xt::empty<double>({n})};
+            double best = ninf;
+            for (std::size_t e = 0; e < n; ++e) {
+                double v = ninf;
+                for (std::size_t w = 0; w < workers; ++w)
+                    v = std::max(v, sup[w][e]);
+                res.sequence(e) = v > ninf ? v : nan;
+                best = std::max(best, v);
+            }
+            if (best > ninf)
+                res.stat = best;
+            return res;
+        }
+
+        template <typename T>
+        inline SADFResult gsadf(const xt::xtensor<T, 1>& y, std::size_t minWindow, int lag, std::string regression,
+                                std::size_t nThreads = 0) {
+            return gsadf(y, minWindow, lag, tools::parseTrend(regression), nThreads);
+        }
+
+        template <typename T>
+        inline SADFResult sadf(const xt::xtensor<T, 1>& y, std::size_t minWindow, int lag, std::string regression) {
+            return sadf(y, minWindow, lag, tools::parseTrend(regression));
+        }
+
+        // BSADF for a stream, one observation at a time
+        //
+        // Every observation opens a start point with an empty factor and each new row
+        // of the ADF regression is added to all open start points, so an update costs
+        // O(starts k^2) and gives BSADF for the latest observation, the same value as
+        // the gsadf sequence at that end. With maxWindow set, start points further back
+        // than maxWindow observations are retired, which bounds the cost and memory;
+        // with 0 every start since the first observation is kept, as in PSY.
+        template <typename T>
+        class BasicBSADFMonitor {
+
+            public:
+
+                BasicBSADFMonitor(std::size_t minWindow, int lag = 0, tools::trendType trend = tools::trendType::C,
+                                  std::size_t maxWindow = 0)
+                    : m_minWindow(minWindow), m_maxWindow(maxWindow), m_lag(lag), m_ntrend(tools::ntrendOf(trend)),
+                      m_m(detail::sadfWidth(trend, lag)) {
+                    detail::checkWindow(minWindow, minWindow, trend, lag);
+                    if (maxWindow != 0 && maxWindow < minWindow)
+                        throw std::invalid_argument("tests::adf::BSADFMonitor : maxWindow must be at least minWindow.");
+                    m_hist.resize(static_cast<std::size_t>(lag) + 2);
+                    m_row.resize(m_m);
+                    m_x.resize(m_m);
+                }
+
+                // Adds y_t and returns BSADF_t, NaN until minWindow observations
+                double update(T y) {
+                    const std::size_t t = m_count++;
+
+                    // last lag + 2 levels, y_t last
+                    std::copy(m_hist.begin() + 1, m_hist.end(), m_hist.begin());
+                    m_hist.back() = y;
+                    if (t == 0)
+                        m_ref = m_ntrend > 0 ? y : T(0);
+
+                    // open the start point t
+                    m_L.resize(m_L.size() + m_m * m_m, T(0));
+                    m_nobs.push_back(0);
+
+                    // retire start points whose window would exceed maxWindow
+                    if (m_maxWindow != 0) {
+                        while (t + 1 - (m_first + m_retired) > m_maxWindow) {
+                            ++m_first;
+                        }
+                        // compact once the retired prefix dominates, amortized O(1)
+                        if (m_first > m_nobs.size() / 2) {
+                            m_L.erase(m_L.begin(), m_L.begin() + m_first * m_m * m_m);
+                            m_nobs.erase(m_nobs.begin(), m_nobs.begin() + m_first);
+                            m_retired += m_first;
+                            m_first = 0;
+                        }
+                    }
+
+                    m_last = std::numeric_limits<double>::quiet_NaN();
+                    const std::size_t first = static_cast<std::size_t>(m_lag) + 1;
+                    if (t < first)
+                        return m_last;
+
+                    T tau = static_cast<T>(t) / static_cast<T>(m_minWindow);
+                    detail::sadfRow(m_row.data(), m_hist.data() + first, m_ntrend, m_lag, tau, m_ref);
+
+                    // start s has a row for t once t >= s + lag + 1
+                    double best = -std::numeric_limits<double>::infinity();
+                    const std::size_t mm = m_m * m_m;
+                    for (std::size_t i = m_first; i < m_nobs.size(); ++i) {
+                        const std::size_t s = i + m_retired;
+                        if (t < s + first)
+                            break;
+                        T* L = m_L.data() + i * mm;
+                        std::copy(m_row.begin(), m_row.end(), m_x.begin());
+                        linModels::solvers::cholUpdate(L, m_m, m_x.data());
+                        ++m_nobs[i];
+                        if (t + 1 >= s + m_minWindow) {
+                            double stat = detail::levelTStat(L, m_m, m_nobs[i]);
+                            if (stat > best)
+                                best = stat;
+                        }
+                    }
+
+                    if (best > -std::numeric_limits<double>::infinity()) {
+                        m_last = best;
+                        if (!(m_sup >= best))
+                            m_sup = best;
+                    }
+                    return m_last;
+                }
+
+                // BSADF of the latest observation
+                double value() const {return m_last;}
+
+                // Supremum of BSADF so far, GSADF of the stream
+                double supremum() const {return m_sup;}
+
+                std::size_t count() const {return m_count;}
+
+            private:
+
+                std::size_t m_minWindow;
+                std::size_t m_maxWindow;
+                int m_lag;
+                std::size_t m_ntrend;
+                std::size_t m_m; // regressors plus the dependent variable
+
+                std::vector<T> m_hist; // latest lag + 2 levels
+                std::vector<T> m_row;
+                std::vector<T> m_x;
+                T m_ref = 0.0;
+
+                std::vector<T> m_L; // factor per start point, (m, m) each
+                std::vector<std::size_t> m_nobs; // rows per start point
+                std::size_t m_first = 0; // first open start point in m_L
+                std::size_t m_retired = 0; // start points compacted away
+
+                std::size_t m_count = 0;
+                double m_last = std::numeric_limits<double>::quiet_NaN();
+                double m_sup = std::numeric_limits<double>::quiet_NaN();
+        };
+
+        using BSADFMonitor = BasicBSADFMonitor<double>;
+    }
+}
+
+#endif // SADF_H_
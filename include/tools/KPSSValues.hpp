@@ -0,0 +1,49 @@
+#ifndef KPSSVALUES_H_
+#define KPSSVALUES_H_
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+#include "trend.hpp"
+
+namespace tools {
+
+    namespace kpss {
+
+        // Upper tail significance levels of the tables, as in Kwiatkowski et al. (1992) table 1
+        inline constexpr std::array<double, 4> levels = {0.10, 0.05, 0.025, 0.01};
+
+        inline constexpr std::array<double, 4> crit_c = {0.347, 0.463, 0.574, 0.739};
+        inline constexpr std::array<double, 4> crit_ct = {0.119, 0.146, 0.176, 0.216};
+
+        // 10%, 5%, 2.5% and 1% critical values for level (C) or trend (CT) stationarity
+        inline const std::array<double, 4>& crit_value(trendType regression) {
+            switch (regression) {
+                case trendType::C: return crit_c;
+                case trendType::CT: return crit_ct;
+                default: break;
+            }
+            throw std::invalid_argument("tools::kpss::crit_value : Regression must be 'c' or 'ct'.");
+        }
+
+        // p-value interpolated linearly in the table and clamped to [0.01, 0.10] outside it
+        inline double p_value(double teststat, trendType regression) {
+            const std::array<double, 4>& crit = crit_value(regression);
+            if (std::isnan(teststat))
+                return teststat;
+            if (teststat <= crit[0])
+                return levels[0];
+            for (std::size_t i = 1; i < crit.size(); ++i) {
+                if (teststat <= crit[i]) {
+                    double w = (teststat - crit[i - 1]) / (crit[i] - crit[i - 1]);
+                    return levels[i - 1] + w * (levels[i] - levels[i - 1]);
+                }
+            }
+            return levels.back();
+        }
+    }
+}
+
+#endif // KPSSVALUES_H_
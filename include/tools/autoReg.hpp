@@ -2,30 +2,122 @@
 #define AUTOREG_H_
 
 #include "coreTools.hpp"
+#include "lagMatrix.hpp"
+#include "parallel.hpp"
+#include "../models/linear/OLSEstimator.hpp"
+#include <cmath>
+#include <cstddef>
+#include <limits>
 #include <xtensor/containers/xtensor.hpp>
 #include <xtensor/views/xview.hpp>
 
 namespace tools {
 
-    inline double AROneHalfLife(xt::xtensor<double, 1> exog) {
-        // centre th series
-        xt::xtensor<double, 1> x = exog - xt::mean(exog);
+    // Half life of an AR(1) process with coefficient phi
+    template <typename T>
+    inline T halfLife(T phi) {
+        return -(std::log(2.) / std::log(std::abs(phi)));
+    }
 
-        // get lagged and current values
-        xt::xtensor<double, 1> x_lag = xt::view(x, xt::range(0, x.size()-1));
-        auto x_cur = xt::view(x, xt::range(1, xt::placeholders::_));
+    // AR(1) slope from the sufficient statistics of the regression x_t = c + phi x_{t-1}
+    // over m (x_{t-1}, x_t) pairs. The slope is invariant to shifting the series, so the
+    // sums may be taken about any reference level.
+    template <typename T>
+    inline T AROnePhi(T m, T sumLag, T sumCur, T sumLagSq, T sumCross) {
+        return (m * sumCross - sumLag * sumCur) / (m * sumLagSq - sumLag * sumLag);
+    }
+
+    template <typename T>
+    inline T AROneHalfLife(xt::xtensor<T, 1> exog) {
+        // centre th series
+        xt::xtensor<T, 1> x = exog - xt::mean(exog);
 
-        // add constant trend to lag values
-        xt::xtensor<double, 2> x_lag_c = tools::addTrend(x_lag, "c", true);
+        // regress x_t on [1, x_{t-1}] through lazy views over x
+        tools::BasicLagMatrix<T> x_lag_c(x.data(), x.size(), 1, 1, 1, true, x.data());
+        tools::BasicVectorView<T> x_cur(x.data() + 1, x.size() - 1);
 
-        // Use OLS model to get phi
-        linModels::OLSModel ols(x_lag_c, x_cur);
-        ols.fit();
-        double phi = ols.getParams()(1);
+        // Use OLS to get phi
+        linModels::BasicOLSEstimator<T> ols;
+        linModels::BasicRegressionResult<T> res;
+        ols.fit(x_lag_c, x_cur, res);
+        T phi = res.params(1);
 
         // calculate half life and return
-        double h = -(std::log(2.) / std::log(abs(phi)));
-        return h;
+        return halfLife(phi);
+    }
+
+    // AR(1) slope of the n values at x in one pass over the cross products
+    //
+    // The sums are taken about x[0], which AROnePhi allows, and split over four
+    // independent accumulators so the loop is not bound by the add latency and
+    // the compiler can pack the lanes. NaN for fewer than three values.
+    template <typename T>
+    inline T AROnePhi(const T* x, std::size_t n) {
+        if (n < 3)
+            return std::numeric_limits<T>::quiet_NaN();
+
+        const T ref = x[0];
+        const std::size_t m = n - 1;
+
+        T s[4] = {}, ss[4] = {}, sc[4] = {};
+        std::size_t i = 0;
+        for (; i + 4 <= m; i += 4) {
+            for (std::size_t l = 0; l < 4; ++l) {
+                T a = x[i + l] - ref;
+                T b = x[i + l + 1] - ref;
+                s[l] += a;
+                ss[l] += a * a;
+                sc[l] += a * b;
+            }
+        }
+        for (; i < m; ++i) {
+            T a = x[i] - ref;
+            s[0] += a;
+            ss[0] += a * a;
+            sc[0] += a * (x[i + 1] - ref);
+        }
+
+        T sumLag = (s[0] + s[1]) + (s[2] + s[3]);
+        T sumLagSq = (ss[0] + ss[1]) + (ss[2] + ss[3]);
+        T sumCross = (sc[0] + sc[1]) + (sc[2] + sc[3]);
+        // the current values are the lagged ones shifted by one, x[0] - ref is zero
+        T sumCur = sumLag + (x[m] - ref);
+
+        return AROnePhi(static_cast<T>(m), sumLag, sumCur, sumLagSq, sumCross);
+    }
+
+    template <typename T>
+    inline void AROnePanel(const xt::xtensor<T, 2>& panel, xt::xtensor<T, 1>& phi, xt::xtensor<T, 1>& halfLives,
+                           std::size_t nThreads = 0) {
+        /*
+         * panel : 2d array (series, time), each row is one spread
+         *
+         * phi, halfLives : resized to the number of rows and filled with the AR(1)
+         *                  coefficient and half life of each row
+         *
+         * nThreads : int, number of worker threads, 0 uses the hardware concurrency
+         *
+         * No design matrix is built, each row costs a single pass of AROnePhi.
+         */
+
+        const std::size_t nseries = panel.shape(0);
+        const std::size_t n = panel.shape(1);
+        phi.resize({nseries});
+        halfLives.resize({nseries});
+
+        // rows are cheap, hand them out in blocks to keep the shared counter cold
+        parallelFor(nseries, nThreads, [&](std::size_t r, std::size_t) {
+            T p = AROnePhi(panel.data() + r * n, n);
+            phi(r) = p;
+            halfLives(r) = halfLife(p);
+        }, 64);
+    }
+
+    template <typename T>
+    inline xt::xtensor<T, 1> AROneHalfLifePanel(const xt::xtensor<T, 2>& panel, std::size_t nThreads = 0) {
+        xt::xtensor<T, 1> phi, halfLives;
+        AROnePanel(panel, phi, halfLives, nThreads);
+        return halfLives;
     }
 
 }
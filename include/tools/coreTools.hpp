@@ -1,7 +1,10 @@
 #ifndef TOOLS_H_
 #define TOOLS_H_
 
+#include <algorithm>
 #include <stdexcept>
+#include <type_traits>
+#include <vector>
 #include <xtensor/containers/xarray.hpp>
 #include <xtensor/views/xview.hpp>
 #include <xtensor/core/xmath.hpp>
@@ -9,13 +12,18 @@
 
 #include "../models/linear/RegressionModel.hpp"
 #include "../models/linear/modelHelpers.hpp"
+#include "../models/linear/NestedOLS.hpp"
+#include "instrumentation.hpp"
+#include "lagMatrix.hpp"
+#include "trend.hpp"
 
 namespace tools {
 
     // lagmat will return a 2d tensor of lags
-    inline xt::xtensor<double, 2> lagmat(xt::xtensor<double, 2>& x, int maxlag, std::string trim, std::string original) {
+    template <typename T>
+    inline xt::xtensor<T, 2> lagmat(xt::xtensor<T, 2>& x, int maxlag, std::string trim, std::string original) {
         /*
-         * x : xarray<double>, input at most 2D
+         * x : xarray<T>, input at most 2D
          *
          * maxlag : int, all lags from zero to maxlag are included
          *
@@ -31,6 +39,8 @@ namespace tools {
          *              array.
          */
 
+        TSA_STAGE(LAGMAT);
+
         // should check strings ...
 
         // Compute shape of tensor
@@ -55,7 +65,7 @@ namespace tools {
         std::size_t dropidx = (original == "ex") ? nvar : 0;
 
         // fill new zeros xtensor
-        xt::xtensor<double, 2> lm = xt::zeros<double>({nobs + static_cast<std::size_t>(maxlag),
+        xt::xtensor<T, 2> lm = xt::zeros<T>({nobs + static_cast<std::size_t>(maxlag),
                 nvar * (static_cast<std::size_t>(maxlag) + 1)});
 
         // equivelant of :
@@ -75,26 +85,65 @@ namespace tools {
         std::size_t startobs = (trim == "none" || trim == "forward") ? 0 : static_cast<std::size_t>(maxlag);
         std::size_t stopobs = (trim == "none" || trim == "backward") ? lm.shape()[0] : nobs;
 
-        xt::xtensor<double, 2> lags = xt::view(lm, xt::range(startobs, stopobs), xt::range(dropidx, lm.shape()[1]));
+        xt::xtensor<T, 2> lags = xt::view(lm, xt::range(startobs, stopobs), xt::range(dropidx, lm.shape()[1]));
         return lags;
     }
 
     // Handle 1D tensors for lagmat
-    inline xt::xtensor<double, 2> lagmat(xt::xtensor<double, 1>& x, int maxlag, std::string trim, std::string original) {
-        xt::xtensor<double, 2> x2 = xt::expand_dims(x, 1);
+    template <typename T>
+    inline xt::xtensor<T, 2> lagmat(xt::xtensor<T, 1>& x, int maxlag, std::string trim, std::string original) {
+        xt::xtensor<T, 2> x2 = xt::expand_dims(x, 1);
         return lagmat(x2, maxlag, trim, original);
     }
 
     // Prepends/appends columns for constant and/or (linear, quadratic) trend to the design matrix.
     // For example a 2D array of (n, p) will be reshaped to (n, p + k), k being the number of trend values
-    inline xt::xtensor<double, 2> addTrend(const xt::xtensor<double, 2>& x, std::string trend, bool prepend) {
+    // The trend specification is fixed at compile time, so the output width is known and the
+    // trend columns are written straight into it.
+    template <trendType TT, typename T>
+    inline xt::xtensor<T, 2> addTrend(const xt::xtensor<T, 2>& x, bool prepend) {
+        constexpr std::size_t ntrend = trendTraits<TT>::ntrend;
+        TSA_STAGE(ADDTREND);
+
+        std::size_t nobs = x.shape(0);
+        std::size_t p = x.shape(1);
+
+        xt::xtensor<T, 2> result = xt::empty<T>({nobs, p + ntrend});
+
+        std::size_t xoff = prepend ? ntrend : 0;
+        std::size_t toff = prepend ? 0 : p;
+
+        for (std::size_t i = 0; i < nobs; ++i) {
+            for (std::size_t j = 0; j < p; ++j)
+                result(i, xoff + j) = x(i, j);
+
+            // trends 1, 2, ..., nobs
+            T t = static_cast<T>(i + 1);
+            if constexpr (ntrend >= 1)
+                result(i, toff) = 1.0;
+            if constexpr (ntrend >= 2)
+                result(i, toff + 1) = t;
+            if constexpr (ntrend >= 3)
+                result(i, toff + 2) = t * t;
+        }
+
+        return result;
+    }
+
+    template <trendType TT, typename T>
+    inline xt::xtensor<T, 2> addTrend(const xt::xtensor<T, 1>& x, bool prepend) {
+        xt::xtensor<T, 2> x2 = xt::expand_dims(x, 1);
+        return addTrend<TT, T>(x2, prepend);
+    }
+
+    template <typename T>
+    inline xt::xtensor<T, 2> addTrend(const xt::xtensor<T, 2>& x, std::string trend, bool prepend) {
         /*
          *
          * X : 2D array
          *
          * trend : string
          *     * "c" add constant only
-         *     * "t" add trend only
          *     * "ct" add constant and linear trend
          *     * "ctt" add constant, linear trend and quadratic trend
          *
@@ -103,54 +152,19 @@ namespace tools {
          *
          */
 
-        // turn trend to lower case
-        std::transform(trend.begin(), trend.end(), trend.begin(), ::tolower);
-
-        // check trend is valid
-        if (trend != "c" && trend != "ct" && trend != "ctt" && trend != "cttt")
+        trendType tt = parseTrend(trend);
+        if (tt == trendType::N)
             throw std::invalid_argument("tools::addTrend : Trend " + trend + " is invalid.");
 
-        // Compute num of objects
-        std::size_t nobs = x.shape(0);
-
-        // build sub trends 1, 2, ..., nobs
-        xt::xtensor<double, 1> constant = xt::arange<double>(1.0, double(nobs) + 1.0);
-        xt::xtensor<double, 2> lin = xt::expand_dims(constant, 1);
-        xt::xtensor<double, 2> quad = xt::expand_dims(xt::eval(xt::pow(constant, 2)), 1);
-
-        // build trend array of shape
-        xt::xtensor<double, 2> trendarr;
-        if (trend == "c") {
-            // constant only
-            std::vector<std::size_t> tdrs = {nobs, 1};
-            trendarr = xt::ones<double>(tdrs);
-        } else if (trend == "t") {
-            // trend only
-            trendarr = lin;
-        } else if (trend == "ct") {
-            // constant + linear
-            std::vector<std::size_t> tdrs = {nobs, 1};
-            trendarr = xt::concatenate(xt::xtuple(xt::ones<double>(tdrs), lin), 1);
-        } else {
-            // constant + linear + quadratic
-            std::vector<std::size_t> tdrs = {nobs, 1};
-            trendarr = xt::concatenate(xt::xtuple(xt::ones<double>(tdrs), lin, quad), 1);
-        }
-
-        // concat along axis=1
-        xt::xtensor<double, 2> result;
-        if (prepend) {
-            result = xt::concatenate(xt::xtuple(trendarr, x), 1);
-        } else {
-            result = xt::concatenate(xt::xtuple(x, trendarr), 1);
-        }
-
-        return result;
+        return withTrend(tt, [&](auto t) {
+            return addTrend<decltype(t)::value, T>(x, prepend);
+        });
     }
 
     // Handle tensor of 1D as input for addTrend
-    inline xt::xtensor<double, 2> addTrend(const xt::xtensor<double, 1>& x, std::string trend, bool prepend) {
-        xt::xtensor<double, 2> x2 = xt::expand_dims(x, 1);
+    template <typename T>
+    inline xt::xtensor<T, 2> addTrend(const xt::xtensor<T, 1>& x, std::string trend, bool prepend) {
+        xt::xtensor<T, 2> x2 = xt::expand_dims(x, 1);
         return addTrend(x2, trend, prepend);
     }
 
@@ -160,10 +174,18 @@ namespace tools {
     };
 
     // Returns the result for the lag length that maximises info criterion
-    inline autoLagResult autoLag(linModels::modelType mod, const xt::xtensor<double, 2>& X, const xt::xtensor<double, 1>& y,
-                            int startLag, int maxLag, std::string method) {
+    // nested holds the factorization scratch so repeated calls can reuse it
+    // X and y may be any expressions with element access, e.g. a lazy tools::LagMatrix
+    template <lagCriterion LC, typename EX, typename EY, typename T>
+    inline autoLagResult autoLag(linModels::modelType mod, const EX& X, const EY& y,
+                            int startLag, int maxLag, linModels::BasicNestedOLS<T>& nested) {
 
         /*
+         * LC : lagCriterion {AIC, BIC, TSTAT}
+         *     - AIC : Akaike Information Criterion
+         *     - BIC : Bayes Information Criterion
+         *     - TSTAT : Based on last lag
+         *
          * mod : linModels::modelType
          *     - Model class type
          *
@@ -178,11 +200,6 @@ namespace tools {
          *
          * maxLag : int
          *     - The highest lag order for lag length selection
-         *
-         * method : string {"aic", "bic", "t-stat"}
-         *     - aic : Akaike Information Criterion
-         *     - bic : Bayes Information Criterion
-         *     - t-stat : Based on last lag
          */
 
         /*
@@ -195,39 +212,59 @@ namespace tools {
          *     - Lag length that maximises information crtiterion
          */
 
-        // dictionary storing key-value (lag, results) pairs
-        std::unordered_map<int, linModels::RegressionResult> results;
-        std::transform(method.begin(), method.end(), method.begin(), ::tolower);
-
-        // Loop over lags from startLag to startLag + maxLag (inclusive)
-        for(int lag = startLag; lag < startLag + maxLag + 1; lag++) {
-            std::unique_ptr<linModels::RegressionModel> modInstance = linModels::getModelOfType(mod, xt::view(X, xt::all(), xt::range(0, lag)), y);
-            results[lag] = modInstance->fit(); // Store model result
+        static_assert(LC != lagCriterion::NONE, "tools::autoLag : A selection criterion is required.");
+
+        // Information criteria and last t-stat for each lag, indexed by lag - startLag
+        const T* aics;
+        const T* bics;
+        const T* tstats;
+        std::vector<T> aicBuf, bicBuf, tstatBuf;
+
+        if (mod == linModels::OLS) {
+            // candidate models are nested column prefixes of X so a single
+            // factorization yields the statistics for every lag order
+            const linModels::BasicNestedRegressionResult<T>& res = nested.fit(X, y, startLag, startLag + maxLag);
+            aics = res.aic.data() + startLag;
+            bics = res.bic.data() + startLag;
+            tstats = res.tLast.data() + startLag;
+        } else {
+            const std::size_t n = X.shape(0);
+            xt::xtensor<T, 1> yc = xt::empty<T>({n});
+            for (std::size_t i = 0; i < n; ++i)
+                yc(i) = y(i);
+
+            // Loop over lags from startLag to startLag + maxLag (inclusive)
+            for(int lag = startLag; lag < startLag + maxLag + 1; lag++) {
+                xt::xtensor<T, 2> Xl = xt::empty<T>({n, static_cast<std::size_t>(lag)});
+                for (std::size_t i = 0; i < n; ++i)
+                    for (std::size_t j = 0; j < static_cast<std::size_t>(lag); ++j)
+                        Xl(i, j) = X(i, j);
+
+                std::unique_ptr<linModels::BasicRegressionModel<T>> modInstance = linModels::getModelOfType(mod, Xl, yc);
+                TSA_COUNT(modelFits);
+                linModels::BasicRegressionResult<T> res = modInstance->fit();
+                aicBuf.push_back(res.aic);
+                bicBuf.push_back(res.bic);
+                tstatBuf.push_back(res.tValues.back());
+            }
+            aics = aicBuf.data();
+            bics = bicBuf.data();
+            tstats = tstatBuf.data();
         }
 
         double icbest; // Best information criterion
         int bestLag; // Corresponding lag
 
-        // Select lag with lowest AIC
-        if (method == "aic") {
-            auto best = std::min_element(results.begin(), results.end(), [](const auto& a, const auto& b) {
-                return a.second.aic < b.second.aic;
-            });
+        // Select lag with lowest AIC or BIC, ties go to the shorter lag
+        if constexpr (LC == lagCriterion::AIC || LC == lagCriterion::BIC) {
+            const T* ics = (LC == lagCriterion::AIC) ? aics : bics;
+            const T* best = std::min_element(ics, ics + maxLag + 1);
 
-            icbest = best->second.aic;
-            bestLag = best->second.lag;
-        }
-        // Select lag with lowest BIC
-        else if (method == "bic") {
-            auto best = std::min_element(results.begin(), results.end(), [](const auto& a, const auto& b) {
-                return a.second.bic < b.second.bic;
-            });
-
-            icbest = best->second.bic;
-            bestLag = best->first;
+            icbest = *best;
+            bestLag = startLag + static_cast<int>(best - ics);
         }
         // Select highest lag where last t-stat is statistically significant
-        else if (method == "t-stat") {
+        else {
             double stop = 1.6448536269514722; // 95% critical value
 
             bestLag = startLag + maxLag;
@@ -235,17 +272,38 @@ namespace tools {
 
             // Iterate backwards from largest to smallest lag
             for(int lag = startLag + maxLag; lag > startLag - 1; lag--) {
-                icbest = std::abs(results[lag].tValues.back());
+                icbest = std::abs(static_cast<double>(tstats[lag - startLag]));
                 bestLag = lag;
                 if (std::abs(icbest) >= stop)
                     break; // break for first lag with significant t-stat
             }
-        } else {
-            throw std::invalid_argument("tools::autoLag : Invalid method.");
         }
 
         return {icbest, bestLag};
     }
+
+    // method : string {"aic", "bic", "t-stat"}, case insensitive
+    template <typename EX, typename EY, typename T>
+    inline autoLagResult autoLag(linModels::modelType mod, const EX& X, const EY& y,
+                            int startLag, int maxLag, const std::string& method, linModels::BasicNestedOLS<T>& nested) {
+        lagCriterion lc = parseCriterion(method);
+        if (lc == lagCriterion::NONE)
+            throw std::invalid_argument("tools::autoLag : Invalid method.");
+
+        return withCriterion(lc, [&](auto c) -> autoLagResult {
+            if constexpr (decltype(c)::value == lagCriterion::NONE)
+                return {0.0, startLag + maxLag}; // unreachable
+            else
+                return autoLag<decltype(c)::value>(mod, X, y, startLag, maxLag, nested);
+        });
+    }
+
+    template <typename EX, typename EY>
+    inline autoLagResult autoLag(linModels::modelType mod, const EX& X, const EY& y,
+                            int startLag, int maxLag, const std::string& method) {
+        linModels::BasicNestedOLS<std::decay_t<decltype(X(0, 0))>> nested;
+        return autoLag(mod, X, y, startLag, maxLag, method, nested);
+    }
 }
 
 #endif // TOOLS_H_
@@ -0,0 +1,259 @@
+#ifndef INSTRUMENTATION_H_
+#define INSTRUMENTATION_H_
+
+/**
+ * Opt-in stage timing, fit and allocation counters
+ *
+ * Compile with -DTSA_INSTRUMENT to enable. Otherwise every TSA_* macro below
+ * expands to nothing and the library carries no instrumentation code at all.
+ *
+ * When enabled, each thread accumulates into its own tools::instrument::Stats
+ * (threadStats()), so no locks or atomics sit on the hot path. A caller supplied
+ * sink additionally receives one Event per completed stage and per warning, from
+ * whichever thread produced it, so the sink must be thread safe.
+ *
+ * Allocation counts need the global operator new to report to this header.
+ * Define TSA_INSTRUMENT_DEFINE_ALLOC_HOOKS in exactly one translation unit,
+ * before including any tsa header, to install counting replacements, aligned
+ * forms included. Without them the allocation fields stay zero. The hooks can be
+ * installed without TSA_INSTRUMENT, and TSA_INSTRUMENT_ALLOC_OBSERVER(n), if
+ * defined, is also invoked with the size of every allocation, which is how
+ * tsa_bench gets its per op counts from the same replacements.
+ */
+
+#ifdef TSA_INSTRUMENT
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+
+namespace tools {
+
+    namespace instrument {
+
+        // Timed sections of the library
+        enum class stage {
+            DIFF, // differencing the series
+            LAGMAT, // materialized lag matrix
+            ADDTREND, // materialized trend columns
+            AUTOLAG, // lag length selection
+            FIT, // final regression
+            PVALUE, // MacKinnon p-value
+            CRITVALUE, // MacKinnon critical values
+            COUNT
+        };
+
+        inline const char* stageName(stage s) {
+            switch (s) {
+                case stage::DIFF: return "diff";
+                case stage::LAGMAT: return "lagmat";
+                case stage::ADDTREND: return "addTrend";
+                case stage::AUTOLAG: return "autoLag";
+                case stage::FIT: return "fit";
+                case stage::PVALUE: return "pValue";
+                case stage::CRITVALUE: return "critValue";
+                case stage::COUNT: break;
+            }
+            return "";
+        }
+
+        constexpr std::size_t nStages = static_cast<std::size_t>(stage::COUNT);
+
+        struct Stats {
+            std::array<std::uint64_t, nStages> ns{}; // wall time per stage
+            std::array<std::uint64_t, nStages> calls{}; // entries per stage
+            std::array<std::uint64_t, nStages> allocs{}; // allocations inside each stage
+            std::array<std::uint64_t, nStages> allocBytes{};
+
+            std::uint64_t olsFits = 0; // OLSEstimator fits
+            std::uint64_t nestedFits = 0; // NestedOLS factorizations
+            std::uint64_t modelFits = 0; // RegressionModel fits through getModelOfType
+            std::uint64_t warnings = 0;
+
+            void reset() {*this = Stats();}
+        };
+
+        enum class eventType {STAGE, WARNING};
+
+        struct Event {
+            eventType type;
+            stage where; // STAGE events only
+            std::uint64_t ns;
+            std::uint64_t allocs;
+            std::uint64_t allocBytes;
+            const char* message; // WARNING events only
+        };
+
+        using Sink = void (*)(const Event& e, void* user);
+
+        namespace detail {
+            inline thread_local Stats t_stats;
+
+            // bumped by the TSA_INSTRUMENT_DEFINE_ALLOC_HOOKS replacements
+            inline thread_local std::uint64_t t_allocs = 0;
+            inline thread_local std::uint64_t t_allocBytes = 0;
+
+            inline std::atomic<Sink> g_sink{nullptr};
+            inline std::atomic<void*> g_user{nullptr};
+
+            inline void emit(const Event& e) {
+                Sink sink = g_sink.load(std::memory_order_acquire);
+                if (sink != nullptr)
+                    sink(e, g_user.load(std::memory_order_relaxed));
+            }
+        }
+
+        // Counters of the calling thread
+        inline Stats& threadStats() {return detail::t_stats;}
+
+        // Install before starting instrumented work, nullptr removes the sink
+        inline void setSink(Sink sink, void* user = nullptr) {
+            detail::g_user.store(user, std::memory_order_relaxed);
+            detail::g_sink.store(sink, std::memory_order_release);
+        }
+
+        inline void warn(const char* message) {
+            ++detail::t_stats.warnings;
+            detail::emit({eventType::WARNING, stage::COUNT, 0, 0, 0, message});
+        }
+
+        // Times the enclosing scope as one entry of stage s
+        class ScopedStage {
+
+            public:
+
+                explicit ScopedStage(stage s)
+                    : m_stage(s), m_allocs(detail::t_allocs), m_bytes(detail::t_allocBytes),
+                      m_start(std::chrono::steady_clock::now()) {}
+
+                ~ScopedStage() {
+                    const std::uint64_t ns = static_cast<std::uint64_t>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - m_start).count());
+                    const std::uint64_t allocs = detail::t_allocs - m_allocs;
+                    const std::uint64_t bytes = detail::t_allocBytes - m_bytes;
+
+                    const std::size_t i = static_cast<std::size_t>(m_stage);
+                    Stats& st = detail::t_stats;
+                    st.ns[i] += ns;
+                    ++st.calls[i];
+                    st.allocs[i] += allocs;
+                    st.allocBytes[i] += bytes;
+
+                    detail::emit({eventType::STAGE, m_stage, ns, allocs, bytes, nullptr});
+                }
+
+                ScopedStage(const ScopedStage&) = delete;
+                ScopedStage& operator=(const ScopedStage&) = delete;
+
+            private:
+
+                stage m_stage;
+                std::uint64_t m_allocs;
+                std::uint64_t m_bytes;
+                std::chrono::steady_clock::time_point m_start;
+        };
+
+    }
+}
+
+#define TSA_INSTRUMENT_CONCAT_(a, b) a##b
+#define TSA_INSTRUMENT_CONCAT(a, b) TSA_INSTRUMENT_CONCAT_(a, b)
+
+#define TSA_STAGE(s) ::tools::instrument::ScopedStage TSA_INSTRUMENT_CONCAT(tsaStage_, __LINE__)(::tools::instrument::stage::s)
+#define TSA_COUNT(field) (++::tools::instrument::threadStats().field)
+#define TSA_WARN(message) ::tools::instrument::warn(message)
+
+#else
+
+#define TSA_STAGE(s) ((void)0)
+#define TSA_COUNT(field) ((void)0)
+#define TSA_WARN(message) ((void)0)
+
+#endif // TSA_INSTRUMENT
+
+#ifdef TSA_INSTRUMENT_DEFINE_ALLOC_HOOKS
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace tools {
+    namespace instrument {
+        namespace detail {
+            inline void countAlloc(std::size_t n) {
+#ifdef TSA_INSTRUMENT
+                ++t_allocs;
+                t_allocBytes += n;
+#endif
+#ifdef TSA_INSTRUMENT_ALLOC_OBSERVER
+                TSA_INSTRUMENT_ALLOC_OBSERVER(n);
+#endif
+                (void)n;
+            }
+
+            inline void* countedAlloc(std::size_t n) {
+                countAlloc(n);
+                return std::malloc(n ? n : 1);
+            }
+
+            // aligned_alloc requires the size to be a multiple of the alignment
+            inline void* countedAlloc(std::size_t n, std::align_val_t al) {
+                countAlloc(n);
+                const std::size_t a = static_cast<std::size_t>(al);
+                return std::aligned_alloc(a, n == 0 ? a : (n + a - 1) / a * a);
+            }
+        }
+    }
+}
+
+void* operator new(std::size_t n) {
+    if (void* p = ::tools::instrument::detail::countedAlloc(n))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t n) {
+    return ::operator new(n);
+}
+
+void* operator new(std::size_t n, const std::nothrow_t&) noexcept {
+    return ::tools::instrument::detail::countedAlloc(n);
+}
+
+void* operator new[](std::size_t n, const std::nothrow_t&) noexcept {
+    return ::tools::instrument::detail::countedAlloc(n);
+}
+
+void* operator new(std::size_t n, std::align_val_t al) {
+    if (void* p = ::tools::instrument::detail::countedAlloc(n, al))
+        return p;
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t n, std::align_val_t al) {
+    return ::operator new(n, al);
+}
+
+void* operator new(std::size_t n, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return ::tools::instrument::detail::countedAlloc(n, al);
+}
+
+void* operator new[](std::size_t n, std::align_val_t al, const std::nothrow_t&) noexcept {
+    return ::tools::instrument::detail::countedAlloc(n, al);
+}
+
+void operator delete(void* p) noexcept {std::free(p);}
+void operator delete[](void* p) noexcept {std::free(p);}
+void operator delete(void* p, std::size_t) noexcept {std::free(p);}
+void operator delete[](void* p, std::size_t) noexcept {std::free(p);}
+void operator delete(void* p, std::align_val_t) noexcept {std::free(p);}
+void operator delete[](void* p, std::align_val_t) noexcept {std::free(p);}
+void operator delete(void* p, std::size_t, std::align_val_t) noexcept {std::free(p);}
+void operator delete[](void* p, std::size_t, std::align_val_t) noexcept {std::free(p);}
+
+#endif // TSA_INSTRUMENT_DEFINE_ALLOC_HOOKS
+
+#endif // INSTRUMENTATION_H_
@@ -0,0 +1,114 @@
+#ifndef LAGMATRIX_H_
+#define LAGMATRIX_H_
+
+#include <cstddef>
+#include <stdexcept>
+
+namespace tools {
+
+    // Non-owning view of n contiguous values, usable wherever a 1D expression
+    // with element access is expected (OLSEstimator, NestedOLS, LeastSquares)
+    template <typename T>
+    class BasicVectorView {
+
+        public:
+
+            BasicVectorView(const T* data, std::size_t n) : m_data(data), m_n(n) {}
+
+            inline T operator()(std::size_t i) const {return m_data[i];}
+            inline std::size_t shape(std::size_t) const {return m_n;}
+            inline std::size_t size() const {return m_n;}
+            inline const T* data() const {return m_data;}
+
+        private:
+
+            const T* m_data;
+            std::size_t m_n;
+    };
+
+    using VectorView = BasicVectorView<double>;
+
+    // Lazy lagged design matrix
+    //
+    // Reads the Hankel layout that lagmat(x, maxlag, "both", "in") materializes straight
+    // from the series: lag column c of row r is x[maxlag + r - c], r = 0, ..., n - maxlag - 1.
+    // Only the first nlags lag columns are exposed. The first lag column can be read from
+    // another series instead, which is how the ADF regression puts the levels x_{t-1} in
+    // front of the differences. ntrend deterministic columns (constant, r + 1, (r + 1)^2)
+    // are generated on the fly, prepended or appended, matching addTrend.
+    //
+    // Nothing is copied, so the series must outlive the view. Elements are accessed
+    // with operator()(r, c) and the shape with shape(axis), which is all the least
+    // squares kernels need.
+    template <typename T>
+    class BasicLagMatrix {
+
+        public:
+
+            BasicLagMatrix(const T* x, std::size_t n, int maxlag, int nlags = -1, int ntrend = 0,
+                      bool prepend = false, const T* first = nullptr)
+                : m_x(x), m_maxlag(static_cast<std::size_t>(maxlag)), m_first(first), m_prepend(prepend) {
+
+                if (maxlag < 0)
+                    throw std::invalid_argument("tools::LagMatrix : maxlag must be non-negative");
+                if (static_cast<std::size_t>(maxlag) >= n)
+                    throw std::invalid_argument("tools::LagMatrix : maxlag must be < nobs");
+                if (ntrend < 0 || ntrend > 3)
+                    throw std::invalid_argument("tools::LagMatrix : ntrend must be between 0 and 3");
+
+                m_nlags = (nlags < 0) ? m_maxlag + 1 : static_cast<std::size_t>(nlags);
+                if (m_nlags > m_maxlag + 1)
+                    throw std::invalid_argument("tools::LagMatrix : nlags must be <= maxlag + 1");
+
+                m_nobs = n - m_maxlag;
+                m_ntrend = static_cast<std::size_t>(ntrend);
+            }
+
+            inline std::size_t shape(std::size_t axis) const {
+                return axis == 0 ? m_nobs : m_nlags + m_ntrend;
+            }
+
+            inline T operator()(std::size_t r, std::size_t c) const {
+                if (m_prepend) {
+                    if (c < m_ntrend)
+                        return trend(r, c);
+                    return lag(r, c - m_ntrend);
+                }
+                if (c < m_nlags)
+                    return lag(r, c);
+                return trend(r, c - m_nlags);
+            }
+
+            inline std::size_t nobs() const {return m_nobs;}
+            inline std::size_t ntrend() const {return m_ntrend;}
+
+        private:
+
+            inline T lag(std::size_t r, std::size_t c) const {
+                if (c == 0 && m_first != nullptr)
+                    return m_first[r];
+                return m_x[m_maxlag + r - c];
+            }
+
+            inline T trend(std::size_t r, std::size_t t) const {
+                if (t == 0)
+                    return 1.0;
+                T v = static_cast<T>(r + 1);
+                return (t == 1) ? v : v * v;
+            }
+
+            const T* m_x;
+            std::size_t m_maxlag;
+            std::size_t m_nlags;
+            std::size_t m_nobs;
+            std::size_t m_ntrend;
+
+            const T* m_first; // replacement for lag column 0, may be null
+            bool m_prepend;
+    };
+
+    using LagMatrix = BasicLagMatrix<double>;
+
+}
+
+#endif // LAGMATRIX_H_
@@ -0,0 +1,178 @@
+#ifndef LAGVARIANCE_H_
+#define LAGVARIANCE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+#include "parallel.hpp"
+
+namespace tools {
+
+    // Lags minLag, minLag + step, ..., up to and including maxLag
+    inline std::vector<int> linearLags(int minLag, int maxLag, int step = 1) {
+        if (minLag < 1 || maxLag < minLag || step < 1)
+            throw std::invalid_argument("tools::linearLags : Invalid lag range.");
+
+        std::vector<int> lags;
+        lags.reserve(static_cast<std::size_t>((maxLag - minLag) / step + 1));
+        for (int lag = minLag; lag <= maxLag; lag += step)
+            lags.push_back(lag);
+        return lags;
+    }
+
+    // Up to count geometrically spaced lags from minLag to maxLag, rounded and
+    // deduplicated so short ranges may return fewer than count lags
+    inline std::vector<int> logLags(int minLag, int maxLag, int count) {
+        if (minLag < 1 || maxLag < minLag || count < 2)
+            throw std::invalid_argument("tools::logLags : Invalid lag range.");
+
+        const double lo = std::log(static_cast<double>(minLag));
+        const double step = (std::log(static_cast<double>(maxLag)) - lo) / (count - 1);
+
+        std::vector<int> lags;
+        lags.reserve(static_cast<std::size_t>(count));
+        for (int i = 0; i < count; ++i) {
+            int lag = static_cast<int>(std::lround(std::exp(lo + step * i)));
+            lag = std::min(std::max(lag, minLag), maxLag);
+            if (lags.empty() || lag > lags.back())
+                lags.push_back(lag);
+        }
+        return lags;
+    }
+
+    // Population variance of the lagged differences x_t - x_{t-lag} for every lag
+    //
+    // The mean of each lag's differences telescopes to
+    //
+    //     mu_l = (sum of the last l values - sum of the first l values) / (n - l)
+    //
+    // so it costs O(max lag) and the variance is accumulated as sum (d - mu_l)^2 in
+    // a single pass, which keeps two-pass accuracy for price levels. The series is
+    // swept in blocks that stay cache resident while every lag of the block is
+    // accumulated, instead of one full pass over memory per lag. With nThreads
+    // workers the grid is split into one contiguous range of lags per worker, so a
+    // single thread makes exactly one sweep over the series.
+    template <typename T>
+    inline void lagDiffVariance(const T* x, std::size_t n, const std::vector<int>& lags,
+                                T* var, std::size_t nThreads = 1) {
+        /*
+         * x : pointer to n contiguous observations
+         *
+         * lags : lag grid, each lag must be in [1, n - 1)
+         *
+         * var : output, var[i] is the variance for lags[i]
+         *
+         * nThreads : number of workers, 0 uses the hardware concurrency
+         */
+
+        const std::size_t nl = lags.size();
+        if (nl == 0)
+            return;
+        int maxLag = 0;
+        for (int lag : lags) {
+            if (lag < 1 || static_cast<std::size_t>(lag) + 1 >= n)
+                throw std::invalid_argument("tools::lagDiffVariance : Lags must be between 1 and nobs - 2.");
+            maxLag = std::max(maxLag, lag);
+        }
+
+        // head and tail sums for every lag up to the largest
+        std::vector<T> head(static_cast<std::size_t>(maxLag) + 1, 0.0);
+        std::vector<T> tail(static_cast<std::size_t>(maxLag) + 1, 0.0);
+        for (std::size_t l = 1; l <= static_cast<std::size_t>(maxLag); ++l) {
+            head[l] = head[l - 1] + x[l - 1];
+            tail[l] = tail[l - 1] + x[n - l];
+        }
+
+        // one contiguous range of lags per worker, so each worker walks every block of
+        // the series once for all of its lags
+        constexpr std::size_t block = 2048;
+        const std::size_t workers = workerCount(nl, nThreads);
+        const std::size_t lagChunk = (nl + workers - 1) / workers;
+        const std::size_t nChunks = (nl + lagChunk - 1) / lagChunk;
+
+        std::vector<T> mu(nl);
+        std::vector<T> acc(nl, 0.0);
+
+        parallelFor(nChunks, nThreads, [&](std::size_t c, std::size_t) {
+            const std::size_t first = c * lagChunk;
+            const std::size_t last = std::min(nl, first + lagChunk);
+
+            std::size_t minLag = n;
+            for (std::size_t i = first; i < last; ++i) {
+                const std::size_t lag = static_cast<std::size_t>(lags[i]);
+                mu[i] = (tail[lag] - head[lag]) / static_cast<T>(n - lag);
+                minLag = std::min(minLag, lag);
+            }
+
+            for (std::size_t t0 = minLag; t0 < n; t0 += block) {
+                const std::size_t t1 = std::min(n, t0 + block);
+                for (std::size_t i = first; i < last; ++i) {
+                    const std::size_t lag = static_cast<std::size_t>(lags[i]);
+                    const T m = mu[i];
+                    const std::size_t start = std::max(t0, lag);
+                    if (start >= t1)
+                        continue;
+                    const T* cur = x + start;
+                    const T* prev = x + (start - lag);
+                    const std::size_t len = t1 - start;
+
+                    // independent partial sums so the loop vectorizes without reassociation
+                    T s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+                    std::size_t j = 0;
+                    for (; j + 4 <= len; j += 4) {
+                        const T d0 = cur[j] - prev[j] - m;
+                        const T d1 = cur[j + 1] - prev[j + 1] - m;
+                        const T d2 = cur[j + 2] - prev[j + 2] - m;
+                        const T d3 = cur[j + 3] - prev[j + 3] - m;
+                        s0 += d0 * d0;
+                        s1 += d1 * d1;
+                        s2 += d2 * d2;
+                        s3 += d3 * d3;
+                    }
+                    for (; j < len; ++j) {
+                        const T d = cur[j] - prev[j] - m;
+                        s0 += d * d;
+                    }
+                    acc[i] += (s0 + s1) + (s2 + s3);
+                }
+            }
+
+            for (std::size_t i = first; i < last; ++i)
+                var[i] = acc[i] / static_cast<T>(n - static_cast<std::size_t>(lags[i]));
+        });
+    }
+
+    // Hurst exponent from the variance of lagged differences
+    //
+    // Fits log(tau) = c + s log(lag) with tau = sqrt(stddev) = var^{1/4} in closed
+    // form and returns 2s, floored at zero as tests::hurst always has.
+    template <typename T>
+    inline T hurstFromVariance(const std::vector<int>& lags, const T* var) {
+        const std::size_t nl = lags.size();
+        if (nl < 2)
+            throw std::invalid_argument("tools::hurstFromVariance : At least two lags are required.");
+
+        T mx = 0.0, my = 0.0;
+        for (std::size_t i = 0; i < nl; ++i) {
+            mx += std::log(static_cast<T>(lags[i]));
+            my += 0.25 * std::log(var[i]);
+        }
+        mx /= static_cast<T>(nl);
+        my /= static_cast<T>(nl);
+
+        T sxx = 0.0, sxy = 0.0;
+        for (std::size_t i = 0; i < nl; ++i) {
+            const T dx = std::log(static_cast<T>(lags[i])) - mx;
+            sxx += dx * dx;
+            sxy += dx * (0.25 * std::log(var[i]) - my);
+        }
+
+        return std::max(T(0), T(2) * sxy / sxx);
+    }
+
+}
+
+#endif // LAGVARIANCE_H_
@@ -0,0 +1,98 @@
+#ifndef LONGRUNVARIANCE_H_
+#define LONGRUNVARIANCE_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+
+namespace tools {
+
+    // Autocovariances gamma[l] = sum_{t >= l} r_t r_{t-l} / n for l = firstLag, ..., lastLag
+    //
+    // r is taken as already demeaned, e.g. regression residuals. Every lag is
+    // accumulated in the same sweep, the series is walked in blocks that stay cache
+    // resident while each lag of the block is summed, instead of one pass over
+    // memory per lag. gamma must hold lastLag + 1 values, entries outside the
+    // requested range are left untouched so a range can be extended later.
+    template <typename T>
+    inline void autocovariances(const T* r, std::size_t n, std::size_t firstLag, std::size_t lastLag, T* gamma) {
+        if (lastLag >= n)
+            throw std::invalid_argument("tools::autocovariances : Lags must be less than nobs.");
+
+        constexpr std::size_t block = 2048;
+
+        for (std::size_t l = firstLag; l <= lastLag; ++l)
+            gamma[l] = 0.0;
+
+        for (std::size_t t0 = firstLag; t0 < n; t0 += block) {
+            const std::size_t t1 = std::min(n, t0 + block);
+            for (std::size_t l = firstLag; l <= lastLag; ++l) {
+                const std::size_t start = std::max(t0, l);
+                if (start >= t1)
+                    continue;
+                const T* cur = r + start;
+                const T* prev = r + (start - l);
+                const std::size_t len = t1 - start;
+
+                // independent partial sums so the loop vectorizes without reassociation
+                T s0 = 0.0, s1 = 0.0, s2 = 0.0, s3 = 0.0;
+                std::size_t j = 0;
+                for (; j + 4 <= len; j += 4) {
+                    s0 += cur[j] * prev[j];
+                    s1 += cur[j + 1] * prev[j + 1];
+                    s2 += cur[j + 2] * prev[j + 2];
+                    s3 += cur[j + 3] * prev[j + 3];
+                }
+                for (; j < len; ++j)
+                    s0 += cur[j] * prev[j];
+                gamma[l] += (s0 + s1) + (s2 + s3);
+            }
+        }
+
+        for (std::size_t l = firstLag; l <= lastLag; ++l)
+            gamma[l] /= static_cast<T>(n);
+    }
+
+    // Newey-West long run variance gamma_0 + 2 sum_{l <= lags} (1 - l / (lags + 1)) gamma_l
+    template <typename T>
+    inline T bartlettLongRunVariance(const T* gamma, std::size_t lags) {
+        T s = 0.0;
+        for (std::size_t l = 1; l <= lags; ++l)
+            s += (1.0 - static_cast<T>(l) / static_cast<T>(lags + 1)) * gamma[l];
+        return gamma[0] + 2.0 * s;
+    }
+
+    // Schwert's rule ceil(12 (n / 100)^{1/4}), the KPSS "legacy" and Phillips-Perron default
+    inline std::size_t schwertLags(std::size_t n) {
+        return static_cast<std::size_t>(std::ceil(12.0 * std::pow(static_cast<double>(n) / 100.0, 0.25)));
+    }
+
+    // Lags whose autocovariances hobijnLags reads, int(n^{2/9})
+    inline std::size_t hobijnCovLags(std::size_t n) {
+        return static_cast<std::size_t>(std::pow(static_cast<double>(n), 2.0 / 9.0));
+    }
+
+    // Data dependent Bartlett bandwidth of Hobijn, Franses and Ooms (1998)
+    //
+    // gamma holds the autocovariances up to hobijnCovLags(n), the result is not
+    // capped, callers limit it to their sample.
+    template <typename T>
+    inline std::size_t hobijnLags(const T* gamma, std::size_t n) {
+        const std::size_t covLags = hobijnCovLags(n);
+        double s0 = static_cast<double>(gamma[0]);
+        double s1 = 0.0;
+        for (std::size_t l = 1; l <= covLags; ++l) {
+            double g = 2.0 * static_cast<double>(gamma[l]);
+            s0 += g;
+            s1 += static_cast<double>(l) * g;
+        }
+        double sHat = s1 / s0;
+        double gammaHat = 1.1447 * std::pow(sHat * sHat, 1.0 / 3.0);
+        double lags = gammaHat * std::pow(static_cast<double>(n), 1.0 / 3.0);
+        return lags > 0.0 ? static_cast<std::size_t>(lags) : 0;
+    }
+
+}
+
+#endif // LONGRUNVARIANCE_H_
@@ -0,0 +1,98 @@
+#ifndef PARALLEL_H_
+#define PARALLEL_H_
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tools {
+
+    // Worker count used when a caller passes nThreads = 0
+    inline std::size_t defaultThreads() {
+        std::size_t n = std::thread::hardware_concurrency();
+        return n == 0 ? 1 : n;
+    }
+
+    // Number of workers parallelFor starts for n tasks, used to size per worker scratch
+    inline std::size_t workerCount(std::size_t n, std::size_t nThreads, std::size_t grain = 1) {
+        if (nThreads == 0)
+            nThreads = defaultThreads();
+        if (grain == 0)
+            grain = 1;
+        return std::max<std::size_t>(1, std::min(nThreads, (n + grain - 1) / grain));
+    }
+
+    // Runs fn(i, worker) for every i in [0, n) on up to nThreads workers
+    //
+    // Workers pull chunks of grain indices from a shared counter so uneven task
+    // costs balance out. worker is in [0, workers) and is stable for the lifetime
+    // of a thread, which lets callers index per worker scratch buffers. The first
+    // exception thrown by fn is rethrown on the calling thread once all workers
+    // have joined. If a worker thread cannot be started, the ones already running
+    // are stopped and joined before the std::system_error is rethrown.
+    template <typename F>
+    inline void parallelFor(std::size_t n, std::size_t nThreads, F&& fn, std::size_t grain = 1) {
+        if (n == 0)
+            return;
+        if (grain == 0)
+            grain = 1;
+
+        std::size_t workers = workerCount(n, nThreads, grain);
+
+        if (workers <= 1) {
+            for (std::size_t i = 0; i < n; ++i)
+                fn(i, std::size_t(0));
+            return;
+        }
+
+        std::atomic<std::size_t> next(0);
+        std::exception_ptr error;
+        std::mutex errorLock;
+
+        auto work = [&](std::size_t worker) {
+            try {
+                for (;;) {
+                    std::size_t start = next.fetch_add(grain, std::memory_order_relaxed);
+                    if (start >= n)
+                        break;
+                    std::size_t stop = std::min(n, start + grain);
+                    for (std::size_t i = start; i < stop; ++i)
+                        fn(i, worker);
+                }
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorLock);
+                if (!error)
+                    error = std::current_exception();
+                // stop handing out work to the other workers
+                next.store(n, std::memory_order_relaxed);
+            }
+        };
+
+        std::vector<std::thread> threads;
+        try {
+            threads.reserve(workers - 1);
+            for (std::size_t w = 1; w < workers; ++w)
+                threads.emplace_back(work, w);
+        } catch (...) {
+            // joinable threads must not be destroyed, stop and join the started ones
+            next.store(n, std::memory_order_relaxed);
+            for (auto& t : threads)
+                t.join();
+            throw;
+        }
+        work(0);
+
+        for (auto& t : threads)
+            t.join();
+
+        if (error)
+            std::rethrow_exception(error);
+    }
+
+}
+
+#endif // PARALLEL_H_
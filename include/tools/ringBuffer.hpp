@@ -0,0 +1,75 @@
+#ifndef RINGBUFFER_H_
+#define RINGBUFFER_H_
+
+#include <cstddef>
+#include <stdexcept>
+#include <vector>
+
+namespace tools {
+
+    // Fixed capacity circular buffer over contiguous storage
+    //
+    // Storage is allocated once on construction, pushing onto a full buffer
+    // overwrites the oldest value in place. Index 0 is always the oldest value.
+    template <typename T>
+    class RingBuffer {
+
+        public:
+
+            RingBuffer() : m_head(0), m_size(0) {}
+
+            explicit RingBuffer(std::size_t capacity) : m_data(capacity), m_head(0), m_size(0) {}
+
+            // Full buffer holding [first, last)
+            template <typename IT>
+            RingBuffer(IT first, IT last) : m_data(first, last), m_head(0), m_size(m_data.size()) {}
+
+            // Appends v, returning the evicted oldest value when full and T() otherwise
+            inline T push(T v) {
+                if (m_data.empty())
+                    throw std::length_error("tools::RingBuffer::push : Buffer has zero capacity.");
+
+                if (m_size < m_data.size()) {
+                    m_data[wrap(m_head + m_size)] = v;
+                    ++m_size;
+                    return T();
+                }
+
+                T old = m_data[m_head];
+                m_data[m_head] = v;
+                if (++m_head == m_data.size())
+                    m_head = 0;
+
+                return old;
+            }
+
+            inline const T& operator[](std::size_t i) const {return m_data[wrap(m_head + i)];}
+            inline T& operator[](std::size_t i) {return m_data[wrap(m_head + i)];}
+
+            inline const T& front() const {return m_data[m_head];}
+            inline const T& back() const {return (*this)[m_size - 1];}
+
+            inline std::size_t size() const {return m_size;}
+            inline std::size_t capacity() const {return m_data.size();}
+            inline bool full() const {return m_size == m_data.size();}
+
+            inline void clear() {
+                m_head = 0;
+                m_size = 0;
+            }
+
+        private:
+
+            // i is at most 2 * capacity - 1 so a single subtraction wraps it
+            inline std::size_t wrap(std::size_t i) const {
+                return (i >= m_data.size()) ? i - m_data.size() : i;
+            }
+
+            std::vector<T> m_data;
+            std::size_t m_head; // index of the oldest value
+            std::size_t m_size;
+    };
+
+}
+
+#endif // RINGBUFFER_H_
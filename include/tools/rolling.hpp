@@ -1,10 +1,23 @@
 #ifndef ROLLING_H_
 #define ROLLING_H_
 
-#include <deque>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
 #include <xtensor/containers/xtensor.hpp>
 
 #include "autoReg.hpp"
+#include "KPSSValues.hpp"
+#include "lagVariance.hpp"
+#include "longRunVariance.hpp"
+#include "../models/linear/solvers.hpp"
+#include "MacKinnonValues.hpp"
+#include "ringBuffer.hpp"
+#include "trend.hpp"
 
 namespace tools
 {
@@ -12,6 +25,9 @@ namespace tools
     namespace rolling
     {
 
+        // Base for sliding window statistics
+        //
+        // The window lives in a fixed capacity ring buffer so updates never allocate.
         template <typename T>
         class Rolling {
 
@@ -25,74 +41,612 @@ namespace tools
 
             protected:
                 T m_val;
-                std::deque<T> m_w;
+                RingBuffer<T> m_w;
                 int m_ws;
         };
 
-        class Mean : public Rolling<double> {
+        template <typename T>
+        class BasicMean : public Rolling<T> {
 
             public:
 
-                Mean(double initial, xt::xtensor<double, 1> window) : Rolling(initial, window) {
+                BasicMean(T initial, xt::xtensor<T, 1> window) : Rolling<T>(initial, window) {
                     m_sum = xt::sum(window)();
-                    m_val = m_sum / static_cast<double>(m_ws);
+                    this->m_val = m_sum / static_cast<T>(this->m_ws);
                 }
 
-                double update(double next) override {
-                    m_sum -= m_w.front();
-                    m_w.pop_front();
-
-                    m_sum += next;
-                    m_w.push_back(next);
+                T update(T next) override {
+                    m_sum += next - this->m_w.push(next);
 
-                    m_val = m_sum / static_cast<double>(m_ws);
+                    this->m_val = m_sum / static_cast<T>(this->m_ws);
 
-                    return m_val;
+                    return this->m_val;
                 }
 
             private:
 
-                double m_sum;
+                T m_sum;
 
         };
 
-        class HalfLife : public Rolling<double> {
+        // Streaming AR(1) half life
+        //
+        // Keeps the lag/lead sums of the window, taken about a reference level
+        // to limit cancellation, so each tick costs O(1) instead of a full OLS fit.
+        // The sums are rebuilt from the window once every window length ticks to
+        // stop rounding drift from accumulating.
+        template <typename T>
+        class BasicHalfLife : public Rolling<T> {
 
             public:
 
-                HalfLife(double initial, xt::xtensor<double, 1> window) : Rolling(initial, window) {
+                BasicHalfLife(T initial, xt::xtensor<T, 1> window) : Rolling<T>(initial, window) {
+                    if (this->m_ws < 3)
+                        throw std::invalid_argument("tools::rolling::HalfLife : Window must hold at least 3 values.");
+                    recompute();
+                }
+
+                T update(T next) override {
+                    T y0 = this->m_w[0] - m_ref;
+                    T y1 = this->m_w[1] - m_ref;
+                    T yl = this->m_w.back() - m_ref;
+                    T yn = next - m_ref;
+
+                    m_sum += yn - y0;
+                    m_sumSq += yn * yn - y0 * y0;
+                    m_sumCross += yl * yn - y0 * y1;
+
+                    this->m_w.push(next);
+
+                    if (++m_ticks >= this->m_ws)
+                        recompute();
 
+                    this->m_val = tools::halfLife(phi());
+
+                    return this->m_val;
                 }
 
-                // Must be a more efficient way than using OLS each time ...
-                double update(double next) override {
-                    m_w.pop_front();
-                    m_w.push_back(next);
+                // AR(1) coefficient of the current window
+                T phi() const {
+                    T m = static_cast<T>(this->m_ws - 1);
+                    T yf = this->m_w.front() - m_ref;
+                    T yl = this->m_w.back() - m_ref;
+
+                    return tools::AROnePhi(m, m_sum - yl, m_sum - yf, m_sumSq - yl * yl, m_sumCross);
+                }
 
-                    m_val = tools::AROneHalfLife(xt::adapt(m_w));
+            private:
 
-                    return m_val;
+                // Rebuild the sums about the current window mean
+                void recompute() {
+                    m_ref = 0.0;
+                    for (std::size_t i = 0; i < this->m_w.size(); ++i)
+                        m_ref += this->m_w[i];
+                    m_ref /= static_cast<T>(this->m_ws);
+
+                    m_sum = 0.0;
+                    m_sumSq = 0.0;
+                    m_sumCross = 0.0;
+                    T prev = 0.0;
+                    for (std::size_t i = 0; i < this->m_w.size(); ++i) {
+                        T y = this->m_w[i] - m_ref;
+                        m_sum += y;
+                        m_sumSq += y * y;
+                        if (i > 0)
+                            m_sumCross += prev * y;
+                        prev = y;
+                    }
+
+                    m_ticks = 0;
                 }
-             
+
+                T m_ref; // reference level the sums are taken about
+                T m_sum; // sum of y_i over the window
+                T m_sumSq; // sum of y_i^2
+                T m_sumCross; // sum of y_{i-1} y_i
+
+                int m_ticks = 0; // updates since the last rebuild
         };
 
-        class StandardDeviation : public Rolling<double> {
+        // Sliding population standard deviation
+        //
+        // Replacing the oldest value with the newest is a single Welford style
+        // add/remove step on the mean and the sum of squared deviations. The
+        // moments are recomputed with a two pass sweep once every window length
+        // ticks to compensate for rounding drift.
+        template <typename T>
+        class BasicStandardDeviation : public Rolling<T> {
 
             public:
 
-                StandardDeviation(double initial, xt::xtensor<double, 1> window) : Rolling(initial, window) {}
+                BasicStandardDeviation(T initial, xt::xtensor<T, 1> window) : Rolling<T>(initial, window) {
+                    recompute();
+                }
 
                 // Calculate next standard deviation
-                double update(double next) override {
-                    m_w.pop_front();
-                    m_w.push_back(next);
+                T update(T next) override {
+                    T old = this->m_w.push(next);
+
+                    T delta = next - old;
+                    T mean = m_mean + delta / static_cast<T>(this->m_ws);
+                    m_m2 += delta * ((next - mean) + (old - m_mean));
+                    m_mean = mean;
+
+                    if (++m_ticks >= this->m_ws)
+                        recompute();
+                    else if (m_m2 < 0.0)
+                        m_m2 = 0.0;
+
+                    this->m_val = std::sqrt(m_m2 / static_cast<T>(this->m_ws));
+
+                    return this->m_val;
+                }
+
+            private:
+
+                void recompute() {
+                    m_mean = 0.0;
+                    for (std::size_t i = 0; i < this->m_w.size(); ++i)
+                        m_mean += this->m_w[i];
+                    m_mean /= static_cast<T>(this->m_ws);
+
+                    m_m2 = 0.0;
+                    for (std::size_t i = 0; i < this->m_w.size(); ++i) {
+                        T d = this->m_w[i] - m_mean;
+                        m_m2 += d * d;
+                    }
+
+                    m_ticks = 0;
+                }
+
+                T m_mean;
+                T m_m2; // sum of squared deviations from the mean
+
+                int m_ticks = 0; // updates since the last recompute
+        };
+
+        // Sliding window Hurst exponent
+        //
+        // Keeps sum d and sum d^2 of the lagged differences d = x_t - x_{t-l} inside
+        // the window for every lag of the grid. A tick adds the pair ending at the new
+        // value and drops the pair starting at the evicted one, so an update costs
+        // O(number of lags). The log-log slope against the centred log lags, fixed at
+        // construction, is then one weighted sum. The sums are rebuilt with
+        // tools::lagDiffVariance once every window length ticks to bound drift.
+        template <typename T>
+        class BasicHurst : public Rolling<T> {
+
+            public:
+
+                BasicHurst(T initial, xt::xtensor<T, 1> window, std::vector<int> lags = tools::linearLags(2, 99))
+                    : Rolling<T>(initial, window), m_lags(std::move(lags)) {
+                    if (m_lags.size() < 2)
+                        throw std::invalid_argument("tools::rolling::Hurst : At least two lags are required.");
+                    for (int lag : m_lags) {
+                        if (lag < 1 || lag + 1 >= this->m_ws)
+                            throw std::invalid_argument("tools::rolling::Hurst : Lags must be between 1 and window - 2.");
+                    }
+
+                    const std::size_t nl = m_lags.size();
+                    m_sum.resize(nl);
+                    m_sumSq.resize(nl);
+                    m_var.resize(nl);
+                    m_dx.resize(nl);
+                    m_buf.resize(static_cast<std::size_t>(this->m_ws));
+
+                    T mx = 0.0;
+                    for (int lag : m_lags)
+                        mx += std::log(static_cast<T>(lag));
+                    mx /= static_cast<T>(nl);
+
+                    m_sxx = 0.0;
+                    for (std::size_t i = 0; i < nl; ++i) {
+                        m_dx[i] = std::log(static_cast<T>(m_lags[i])) - mx;
+                        m_sxx += m_dx[i] * m_dx[i];
+                    }
+
+                    recompute();
+                    this->m_val = slope();
+                }
+
+                T update(T next) override {
+                    const std::size_t ws = static_cast<std::size_t>(this->m_ws);
+                    const T old = this->m_w.front();
+
+                    for (std::size_t i = 0; i < m_lags.size(); ++i) {
+                        const std::size_t lag = static_cast<std::size_t>(m_lags[i]);
+                        const T dIn = next - this->m_w[ws - lag];
+                        const T dOut = this->m_w[lag] - old;
+                        m_sum[i] += dIn - dOut;
+                        m_sumSq[i] += dIn * dIn - dOut * dOut;
+                    }
+
+                    this->m_w.push(next);
+
+                    if (++m_ticks >= this->m_ws)
+                        recompute();
+
+                    this->m_val = slope();
+
+                    return this->m_val;
+                }
+
+            private:
+
+                // Refit log(sqrt(stddev)) against the log lags, floored at zero like tests::hurst
+                T slope() {
+                    T sxy = 0.0;
+                    for (std::size_t i = 0; i < m_lags.size(); ++i) {
+                        const T m = static_cast<T>(this->m_ws - m_lags[i]);
+                        const T var = std::max((m_sumSq[i] - m_sum[i] * m_sum[i] / m) / m, T(0));
+                        // the centred log lags sum to zero so the mean of the logs drops out
+                        sxy += m_dx[i] * 0.25 * std::log(var);
+                    }
+
+                    return std::max(T(0), T(2) * sxy / m_sxx);
+                }
+
+                // Rebuild the sums from the window with the two pass kernel
+                void recompute() {
+                    for (std::size_t i = 0; i < this->m_w.size(); ++i)
+                        m_buf[i] = this->m_w[i];
+
+                    tools::lagDiffVariance(m_buf.data(), m_buf.size(), m_lags, m_var.data());
+
+                    const std::size_t ws = m_buf.size();
+                    for (std::size_t i = 0; i < m_lags.size(); ++i) {
+                        const std::size_t lag = static_cast<std::size_t>(m_lags[i]);
+                        const T m = static_cast<T>(ws - lag);
+                        // sum of the differences telescopes to the last lag values minus the first
+                        T sum = 0.0;
+                        for (std::size_t j = 0; j < lag; ++j)
+                            sum += m_buf[ws - lag + j] - m_buf[j];
+                        m_sum[i] = sum;
+                        m_sumSq[i] = m_var[i] * m + sum * sum / m;
+                    }
+
+                    m_ticks = 0;
+                }
+
+                std::vector<int> m_lags;
+                std::vector<T> m_sum; // sum of d over the window, per lag
+                std::vector<T> m_sumSq; // sum of d^2, per lag
+                std::vector<T> m_var; // recompute output
+                std::vector<T> m_dx; // centred log lags
+                std::vector<T> m_buf; // contiguous copy of the window for recompute
+                T m_sxx; // sum of m_dx^2
+
+                int m_ticks = 0; // updates since the last recompute
+        };
+
+        // Sliding window ADF statistic with a fixed lag
+        //
+        // Maintains X^{t}X, X^{t}y and y^{t}y of the regression adfuller runs on the
+        // window with autolag disabled, columns [x_{t-1}, dx_{t-1}, ..., dx_{t-lag}, const, trend].
+        // Each tick downdates the oldest row and updates the newest one, so only the
+        // small (k, k) system is solved per tick. When the window slides every trend
+        // value drops by one, i.e. trend <- trend - const, which is applied to the Gram
+        // matrix as a congruence instead of rebuilding it.
+        //
+        // With a constant the level column is taken about a reference level, which
+        // leaves its coefficient unchanged but keeps the normal equations well
+        // conditioned for large prices. The sums are rebuilt from the window once
+        // every window length ticks.
+        template <typename T>
+        class BasicADF : public Rolling<T> {
+
+            public:
+
+                BasicADF(T initial, xt::xtensor<T, 1> window, int lag = 1, std::string regression = "c")
+                    : Rolling<T>(initial, window), m_lag(lag), m_trend(parseTrend(regression)) {
+                    // the trend shift only handles a linear trend column
+                    if (m_trend == trendType::CTT)
+                        throw std::invalid_argument("tools::rolling::ADF : Regression must be 'n', 'c' or 'ct'.");
+                    m_ntrend = static_cast<int>(ntrendOf(m_trend));
+
+                    if (lag < 0)
+                        throw std::invalid_argument("tools::rolling::ADF : Lag must be non-negative.");
+
+                    m_k = 1 + static_cast<std::size_t>(lag) + static_cast<std::size_t>(m_ntrend);
+                    m_rows = static_cast<std::size_t>(this->m_ws) - 1 - static_cast<std::size_t>(lag);
+                    if (this->m_ws < 2 + lag || m_rows <= m_k)
+                        throw std::invalid_argument("tools::rolling::ADF : Window is too short for the lag and regression.");
+
+                    m_G.resize(m_k * m_k);
+                    m_b.resize(m_k);
+                    m_z.resize(m_k);
+                    m_L.resize(m_k * m_k);
+                    m_u.resize(m_k);
+
+                    recompute();
+                    this->m_val = solve();
+                }
 
-                    m_val = xt::stddev(xt::adapt(m_w))();
+                // Returns the ADF t-stat of the window ending at next
+                T update(T next) override {
+                    // downdate the oldest row, its trend value is 1
+                    T y = row(0, 1.0);
+                    rankOne(-1.0, y);
 
-                    return m_val;
+                    if (m_ntrend == 2)
+                        shiftTrend();
+
+                    this->m_w.push(next);
+
+                    if (++m_ticks >= this->m_ws) {
+                        recompute();
+                    } else {
+                        y = row(m_rows - 1, static_cast<T>(m_rows));
+                        rankOne(1.0, y);
+                    }
+
+                    this->m_val = solve();
+
+                    return this->m_val;
+                }
+
+                // MacKinnon p-value of the current statistic
+                double getPValue() const {
+                    return tools::mackinnon::p_value(static_cast<double>(this->m_val), m_trend, 1);
+                }
+
+            private:
+
+                // Fills m_z with design row r (0 is the oldest) and returns its dependent value
+                T row(std::size_t r, T trend) {
+                    std::size_t t = r + 1 + static_cast<std::size_t>(m_lag); // index of x_t in the window
+
+                    m_z[0] = this->m_w[t - 1] - m_ref;
+                    for (int j = 1; j <= m_lag; ++j)
+                        m_z[j] = this->m_w[t - j] - this->m_w[t - j - 1];
+                    if (m_ntrend >= 1)
+                        m_z[1 + m_lag] = 1.0;
+                    if (m_ntrend == 2)
+                        m_z[2 + m_lag] = trend;
+
+                    return this->m_w[t] - this->m_w[t - 1];
+                }
+
+                // Adds sign * (z z^{t}, z y, y^2) to the sums
+                void rankOne(T sign, T y) {
+                    for (std::size_t a = 0; a < m_k; ++a) {
+                        T za = sign * m_z[a];
+                        for (std::size_t b = 0; b < m_k; ++b)
+                            m_G[a * m_k + b] += za * m_z[b];
+                        m_b[a] += za * y;
+                    }
+                    m_yty += sign * y * y;
+                }
+
+                // Applies trend <- trend - const to the sums
+                void shiftTrend() {
+                    std::size_t c = 1 + static_cast<std::size_t>(m_lag);
+                    std::size_t tr = c + 1;
+
+                    for (std::size_t b = 0; b < m_k; ++b)
+                        m_G[tr * m_k + b] -= m_G[c * m_k + b];
+                    for (std::size_t a = 0; a < m_k; ++a)
+                        m_G[a * m_k + tr] -= m_G[a * m_k + c];
+                    m_b[tr] -= m_b[c];
+                }
+
+                // Rebuilds the sums from the window
+                void recompute() {
+                    m_ref = 0.0;
+                    if (m_ntrend > 0) {
+                        for (std::size_t i = 0; i < this->m_w.size(); ++i)
+                            m_ref += this->m_w[i];
+                        m_ref /= static_cast<T>(this->m_ws);
+                    }
+
+                    std::fill(m_G.begin(), m_G.end(), 0.0);
+                    std::fill(m_b.begin(), m_b.end(), 0.0);
+                    m_yty = 0.0;
+
+                    for (std::size_t r = 0; r < m_rows; ++r) {
+                        T y = row(r, static_cast<T>(r + 1));
+                        rankOne(1.0, y);
+                    }
+
+                    m_ticks = 0;
+                }
+
+                // Cholesky solve of the normal equations, returns the t-stat of the level column
+                T solve() {
+                    const std::size_t k = m_k;
+
+                    std::copy(m_G.begin(), m_G.end(), m_L.begin());
+                    if (!linModels::solvers::cholesky(m_L.data(), k))
+                        return std::numeric_limits<T>::quiet_NaN();
+
+                    // L u = X^{t}y gives RSS = y^{t}y - u^{t}u
+                    std::copy(m_b.begin(), m_b.end(), m_u.begin());
+                    linModels::solvers::forwardSubst(m_L.data(), k, m_u.data());
+                    T utu = 0.0;
+                    for (std::size_t i = 0; i < k; ++i)
+                        utu += m_u[i] * m_u[i];
+                    T rss = std::max(m_yty - utu, T(0));
+
+                    linModels::solvers::backSubstT(m_L.data(), k, m_u.data());
+                    T beta0 = m_u[0];
+
+                    // [(X^{t}X)^{-1}]_{00} = ||L^{-1} e_0||^2
+                    std::fill(m_z.begin(), m_z.end(), 0.0);
+                    m_z[0] = 1.0;
+                    linModels::solvers::forwardSubst(m_L.data(), k, m_z.data());
+                    T inv00 = 0.0;
+                    for (std::size_t i = 0; i < k; ++i)
+                        inv00 += m_z[i] * m_z[i];
+
+                    T sigma2 = rss / static_cast<T>(m_rows - k);
+                    return beta0 / std::sqrt(sigma2 * inv00);
+                }
+
+                int m_lag;
+                int m_ntrend;
+                trendType m_trend;
+
+                std::size_t m_k; // regressors
+                std::size_t m_rows; // regression observations in a window
+
+                T m_ref = 0.0; // reference level for the level column
+
+                std::vector<T> m_G; // X^{t}X, row major (k, k)
+                std::vector<T> m_b; // X^{t}y
+                T m_yty = 0.0;
+
+                std::vector<T> m_z; // design row / solve scratch
+                std::vector<T> m_L; // Cholesky factor of m_G
+                std::vector<T> m_u; // solve scratch
+
+                int m_ticks = 0; // updates since the last rebuild
+        };
+
+        // Streaming KPSS level stationarity statistic with a fixed Bartlett bandwidth
+        //
+        // With P_j the partial sums of the window about a reference level and ybar its
+        // mean, the partial sums of the demeaned window are S_j = P_j - (j + 1) ybar, so
+        //
+        //     sum S_j^2 = sum P_j^2 - 2 ybar sum (j + 1) P_j + ybar^2 sum (j + 1)^2
+        //
+        // Dropping the oldest value a and appending b shifts every P_j down by a, which
+        // updates sum P_j, sum P_j^2 and sum (j + 1) P_j in O(1). The lagged cross
+        // products sum y_j y_{j-l} each gain one pair and lose one, and the demeaned
+        // autocovariances follow from them and the head and tail sums of the window,
+        // so a tick costs O(lags) instead of O(window lags). The sums are rebuilt about
+        // the window mean once every window length ticks.
+        template <typename T>
+        class BasicKPSS : public Rolling<T> {
+
+            public:
+
+                BasicKPSS(T initial, xt::xtensor<T, 1> window, int lags = -1) : Rolling<T>(initial, window) {
+                    /*
+                     * lags : Bartlett bandwidth, -1 uses ceil(12 (window / 100)^{1/4})
+                     */
+
+                    const std::size_t ws = static_cast<std::size_t>(this->m_ws);
+                    if (ws < 3)
+                        throw std::invalid_argument("tools::rolling::KPSS : Window must hold at least 3 values.");
+                    m_lags = lags < 0 ? std::min(schwertLags(ws), ws - 1) : static_cast<std::size_t>(lags);
+                    if (m_lags >= ws)
+                        throw std::invalid_argument("tools::rolling::KPSS : Lags must be less than the window.");
+
+                    m_cross.resize(m_lags + 1);
+                    m_gamma.resize(m_lags + 1);
+
+                    recompute();
+                    this->m_val = statistic();
                 }
+
+                // Returns the KPSS statistic of the window ending at next
+                T update(T next) override {
+                    const std::size_t ws = static_cast<std::size_t>(this->m_ws);
+                    const T w = static_cast<T>(ws);
+                    const T a = this->m_w.front() - m_ref;
+                    const T b = next - m_ref;
+
+                    // pairs (y_l, y_0) leave and (b, y_{ws - l}) join, y_{ws - l} is still in the window
+                    m_cross[0] += b * b - a * a;
+                    for (std::size_t l = 1; l <= m_lags; ++l)
+                        m_cross[l] += b * (this->m_w[ws - l] - m_ref) - a * (this->m_w[l] - m_ref);
+
+                    const T last = m_sum - a + b;
+                    m_sumJP += -m_sumP - a * w * (w - 1) / 2 + w * last;
+                    m_sumPP += -2 * a * m_sumP + w * a * a + last * last;
+                    m_sumP += -w * a + last;
+                    m_sum = last;
+
+                    this->m_w.push(next);
+
+                    if (++m_ticks >= this->m_ws)
+                        recompute();
+
+                    this->m_val = statistic();
+
+                    return this->m_val;
+                }
+
+                // p-value interpolated in the KPSS table, clamped to [0.01, 0.10]
+                double getPValue() const {
+                    return tools::kpss::p_value(static_cast<double>(this->m_val), trendType::C);
+                }
+
+                std::size_t lags() const {return m_lags;}
+
+            private:
+
+                T statistic() {
+                    const std::size_t ws = static_cast<std::size_t>(this->m_ws);
+                    const T w = static_cast<T>(ws);
+                    const T ybar = m_sum / w;
+
+                    // sum_{j=1}^{w} j^2
+                    const T sumJJ = w * (w + 1) * (2 * w + 1) / 6;
+                    const T eta = std::max(m_sumPP - 2 * ybar * m_sumJP + ybar * ybar * sumJJ, T(0)) / (w * w);
+
+                    // sum_{t >= l} (y_t - ybar)(y_{t-l} - ybar) from the cross products and the
+                    // sums of all but the first l and all but the last l values
+                    T head = 0.0, tail = 0.0;
+                    for (std::size_t l = 0; l <= m_lags; ++l) {
+                        if (l > 0) {
+                            head += this->m_w[l - 1] - m_ref;
+                            tail += this->m_w[ws - l] - m_ref;
+                        }
+                        T g = m_cross[l] - ybar * ((m_sum - head) + (m_sum - tail)) + static_cast<T>(ws - l) * ybar * ybar;
+                        m_gamma[l] = g / w;
+                    }
+
+                    const T s2 = bartlettLongRunVariance(m_gamma.data(), m_lags);
+                    return s2 > 0.0 ? eta / s2 : std::numeric_limits<T>::quiet_NaN();
+                }
+
+                // Rebuild every sum about the current window mean
+                void recompute() {
+                    const std::size_t ws = static_cast<std::size_t>(this->m_ws);
+                    m_ref = 0.0;
+                    for (std::size_t i = 0; i < ws; ++i)
+                        m_ref += this->m_w[i];
+                    m_ref /= static_cast<T>(ws);
+
+                    m_sum = 0.0;
+                    m_sumP = 0.0;
+                    m_sumPP = 0.0;
+                    m_sumJP = 0.0;
+                    std::fill(m_cross.begin(), m_cross.end(), T(0));
+                    for (std::size_t j = 0; j < ws; ++j) {
+                        T y = this->m_w[j] - m_ref;
+                        m_sum += y;
+                        m_sumP += m_sum;
+                        m_sumPP += m_sum * m_sum;
+                        m_sumJP += static_cast<T>(j + 1) * m_sum;
+                        for (std::size_t l = 0; l <= std::min(j, m_lags); ++l)
+                            m_cross[l] += y * (this->m_w[j - l] - m_ref);
+                    }
+
+                    m_ticks = 0;
+                }
+
+                std::size_t m_lags;
+
+                T m_ref; // reference level the sums are taken about
+                T m_sum; // sum of y_j, the last partial sum
+                T m_sumP; // sum of the partial sums P_j
+                T m_sumPP; // sum of P_j^2
+                T m_sumJP; // sum of (j + 1) P_j
+                std::vector<T> m_cross; // sum_{j >= l} y_j y_{j-l}
+                std::vector<T> m_gamma; // demeaned autocovariances
+
+                int m_ticks = 0; // updates since the last rebuild
         };
 
+        using Mean = BasicMean<double>;
+        using HalfLife = BasicHalfLife<double>;
+        using StandardDeviation = BasicStandardDeviation<double>;
+        using Hurst = BasicHurst<double>;
+        using ADF = BasicADF<double>;
+        using KPSS = BasicKPSS<double>;
+
     }
 }
 
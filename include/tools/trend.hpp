@@ -0,0 +1,105 @@
+#ifndef TREND_H_
+#define TREND_H_
+
+#include <cctype>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+
+namespace tools {
+
+    // Deterministic terms included in a regression
+    enum class trendType {
+        N, // no constant, no trend
+        C, // constant only
+        CT, // constant and linear trend
+        CTT // constant, linear and quadratic trend
+    };
+
+    // Lag length selection criterion
+    enum class lagCriterion {
+        AIC,
+        BIC,
+        TSTAT, // highest lag with a significant last t-stat
+        NONE // use maxlag
+    };
+
+    // Compile time properties of each trend specification
+    template <trendType TT>
+    struct trendTraits {
+        static constexpr std::size_t ntrend = static_cast<std::size_t>(TT);
+    };
+
+    inline constexpr std::size_t ntrendOf(trendType t) {
+        return static_cast<std::size_t>(t);
+    }
+
+    inline const char* trendName(trendType t) {
+        switch (t) {
+            case trendType::N: return "n";
+            case trendType::C: return "c";
+            case trendType::CT: return "ct";
+            case trendType::CTT: return "ctt";
+        }
+        return "";
+    }
+
+    namespace detail {
+        // Case insensitive comparison without copying either string
+        inline bool iequals(const std::string& a, const char* b) {
+            std::size_t i = 0;
+            for (; i < a.size() && b[i] != '\0'; ++i) {
+                if (std::tolower(static_cast<unsigned char>(a[i])) != std::tolower(static_cast<unsigned char>(b[i])))
+                    return false;
+            }
+            return i == a.size() && b[i] == '\0';
+        }
+    }
+
+    // Parses "n" (or "nc"), "c", "ct", "ctt", case insensitive
+    inline trendType parseTrend(const std::string& s) {
+        if (detail::iequals(s, "n") || detail::iequals(s, "nc")) return trendType::N;
+        if (detail::iequals(s, "c")) return trendType::C;
+        if (detail::iequals(s, "ct")) return trendType::CT;
+        if (detail::iequals(s, "ctt")) return trendType::CTT;
+        throw std::invalid_argument("tools::parseTrend : Trend " + s + " is invalid.");
+    }
+
+    // Parses "AIC", "BIC", "t-stat", case insensitive, "" or "none" for no selection
+    inline lagCriterion parseCriterion(const std::string& s) {
+        if (detail::iequals(s, "aic")) return lagCriterion::AIC;
+        if (detail::iequals(s, "bic")) return lagCriterion::BIC;
+        if (detail::iequals(s, "t-stat")) return lagCriterion::TSTAT;
+        if (s.empty() || detail::iequals(s, "none")) return lagCriterion::NONE;
+        throw std::invalid_argument("tools::parseCriterion : Criterion " + s + " is invalid.");
+    }
+
+    // Calls f(std::integral_constant<trendType, t>{}) so a runtime trend can select
+    // a compile time specialization
+    template <typename F>
+    inline decltype(auto) withTrend(trendType t, F&& f) {
+        switch (t) {
+            case trendType::N: return f(std::integral_constant<trendType, trendType::N>{});
+            case trendType::C: return f(std::integral_constant<trendType, trendType::C>{});
+            case trendType::CT: return f(std::integral_constant<trendType, trendType::CT>{});
+            case trendType::CTT: break;
+        }
+        return f(std::integral_constant<trendType, trendType::CTT>{});
+    }
+
+    // As withTrend for the lag criterion
+    template <typename F>
+    inline decltype(auto) withCriterion(lagCriterion c, F&& f) {
+        switch (c) {
+            case lagCriterion::AIC: return f(std::integral_constant<lagCriterion, lagCriterion::AIC>{});
+            case lagCriterion::BIC: return f(std::integral_constant<lagCriterion, lagCriterion::BIC>{});
+            case lagCriterion::TSTAT: return f(std::integral_constant<lagCriterion, lagCriterion::TSTAT>{});
+            case lagCriterion::NONE: break;
+        }
+        return f(std::integral_constant<lagCriterion, lagCriterion::NONE>{});
+    }
+
+}
+
+#endif // TREND_H_